@@ -0,0 +1,6 @@
+gcc -O2 -o scan_bench ../bench/scan_bench.c ../src/scan.c ../src/lexer.c ../src/token.c ../src/source.c ../src/arena.c -I ../include
+scan_bench.exe 16
+gcc -O2 -o symbol_bench ../bench/symbol_bench.c ../src/symbol_table.c ../src/intern.c ../src/arena.c -I ../include
+symbol_bench.exe
+gcc -O2 -o tac_bench ../bench/tac_bench.c ../src/tac.c ../src/ast.c ../src/symbol_table.c ../src/intern.c ../src/arena.c -I ../include
+tac_bench.exe
\ No newline at end of file
@@ -0,0 +1,118 @@
+// Microbenchmark for the lexer's scanning layer.
+// Build: gcc -O2 -o scan_bench bench/scan_bench.c src/scan.c src/lexer.c src/token.c src/source.c src/arena.c -I include
+// Run:   scan_bench [megabytes]
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../include/lexer.h"
+#include "../include/scan.h"
+
+#define REPEATS 5
+
+// Build a BakScript-like source of roughly the requested size
+static char *generate_source(size_t target, size_t *out_length)
+{
+    static const char *lines[] = {
+        "    num accumulated_total_value = accumulated_total_value + loop_counter_index * 2;\n",
+        "        // keep the running total in range before printing the current value\n",
+        "    str greeting_message_for_user = \"Hello from a fairly long string literal!\";\n",
+        "    when (accumulated_total_value > maximum_allowed_value) {\n",
+        "            show(greeting_message_for_user);\n",
+        "    }\n",
+        "\n",
+        "repeat (num loop_counter_index = 0; loop_counter_index < 100; loop_counter_index = loop_counter_index + 1) {\n",
+    };
+    int line_count = sizeof(lines) / sizeof(lines[0]);
+    char *source = (char *)malloc(target + 256);
+    size_t length = 0;
+
+    for (int i = 0; length < target; i++)
+    {
+        const char *line = lines[i % line_count];
+        size_t n = strlen(line);
+        memcpy(source + length, line, n);
+        length += n;
+    }
+    source[length] = '\0';
+    *out_length = length;
+    return source;
+}
+
+static double seconds_since(clock_t start)
+{
+    return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+// Walk the whole buffer the way the lexer does, hitting each scanner in turn
+static size_t sweep(const char *text, size_t length)
+{
+    size_t i = 0;
+    size_t runs = 0;
+
+    while (i < length)
+    {
+        char c = text[i];
+        size_t n;
+        if (c == ' ' || c == '\n' || c == '\t')
+            n = scanner.whitespace(text + i, length - i);
+        else if (c == '/' && text[i + 1] == '/')
+            n = 2 + scanner.line(text + i + 2, length - i - 2);
+        else if (c == '"')
+            n = 2 + scanner.string_body(text + i + 1, length - i - 1);
+        else if (c == '_' || ((c | 0x20) >= 'a' && (c | 0x20) <= 'z'))
+            n = scanner.identifier(text + i, length - i);
+        else
+            n = 1;
+        i += n;
+        runs++;
+    }
+    return runs;
+}
+
+int main(int argc, char *argv[])
+{
+    size_t megabytes = argc > 1 ? (size_t)atoi(argv[1]) : 8;
+    size_t length;
+    char *source = generate_source(megabytes * 1024 * 1024, &length);
+    ScanImpl best = scan_best_impl();
+
+    printf("Source: %.1f MB, best implementation: %s\n\n", length / (1024.0 * 1024.0), scan_impl_name(best));
+    printf("%-8s %14s %14s %14s\n", "impl", "scan (MB/s)", "lexer (MB/s)", "tokens");
+
+    for (int impl = SCAN_SCALAR; impl <= (int)best; impl++)
+    {
+        scan_select((ScanImpl)impl);
+
+        double scan_time = 0;
+        size_t runs = 0;
+        for (int r = 0; r < REPEATS; r++)
+        {
+            clock_t start = clock();
+            runs += sweep(source, length);
+            scan_time += seconds_since(start);
+        }
+
+        double lex_time = 0;
+        int tokens = 0;
+        for (int r = 0; r < REPEATS; r++)
+        {
+            SourceBuffer buffer = {.text = source, .length = length};
+            Lexer *lexer = create_lexer(&buffer);
+            scan_select((ScanImpl)impl);
+            clock_t start = clock();
+            TokenStream *stream = create_token_stream(lexer);
+            lex_time += seconds_since(start);
+            tokens = stream->count;
+            region_release(REGION_TOKENS);
+        }
+
+        double mb = REPEATS * length / (1024.0 * 1024.0);
+        printf("%-8s %14.1f %14.1f %14d\n", scan_impl_name((ScanImpl)impl),
+               mb / scan_time, mb / lex_time, tokens);
+        (void)runs;
+    }
+
+    free(source);
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,94 @@
+// Microbenchmark for the symbol table: insert and lookup cost as the number of
+// live symbols grows from 10 to 100,000.
+// Build: gcc -O2 -o symbol_bench bench/symbol_bench.c src/symbol_table.c src/intern.c src/arena.c -I include
+// Run:   symbol_bench
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "../include/symbol_table.h"
+
+#define LOOKUPS 10000000
+#define SCOPE_DEPTH 8
+
+static double seconds_since(clock_t start)
+{
+    return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+int main(void)
+{
+    static const int sizes[] = {10, 100, 1000, 10000, 100000};
+    int size_count = sizeof(sizes) / sizeof(sizes[0]);
+    int max_size = sizes[size_count - 1];
+
+    // Intern every name up front so only the table itself is measured
+    NameId *names = (NameId *)malloc(max_size * sizeof(NameId));
+    for (int i = 0; i < max_size; i++)
+    {
+        char name[32];
+        int length = snprintf(name, sizeof(name), "var_%d", i);
+        names[i] = intern(name, length);
+    }
+
+    printf("%-10s %16s %16s %16s\n", "symbols", "insert (ns/op)", "lookup (ns/op)", "scope (ns/sym)");
+
+    for (int s = 0; s < size_count; s++)
+    {
+        int count = sizes[s];
+        int rounds = max_size / count;
+        SymbolTable *table = NULL;
+
+        // Small tables are rebuilt several times so every row inserts the same total
+        clock_t start = clock();
+        for (int r = 0; r < rounds; r++)
+        {
+            region_release(REGION_SYMBOLS);
+            table = create_symbol_table(16);
+            for (int i = 0; i < count; i++)
+                symbol_table_insert(table, names[i], SYMBOL_VARIABLE, TYPE_NUM);
+        }
+        double insert_time = seconds_since(start) / rounds;
+
+        // Stride through the names so consecutive lookups hit unrelated slots
+        int stride = 7919;
+        int index = 0;
+        long found = 0;
+        start = clock();
+        for (int i = 0; i < LOOKUPS; i++)
+        {
+            found += symbol_table_lookup(table, names[index]) != NULL;
+            index += stride;
+            if (index >= count)
+                index %= count;
+        }
+        double lookup_time = seconds_since(start);
+
+        // Shadow every name in nested scopes, then unwind them
+        start = clock();
+        for (int r = 0; r < rounds; r++)
+        {
+            for (int depth = 0; depth < SCOPE_DEPTH; depth++)
+            {
+                symbol_table_enter_scope(table);
+                for (int i = 0; i < count; i++)
+                    symbol_table_insert(table, names[i], SYMBOL_VARIABLE, TYPE_NUM);
+            }
+            for (int depth = 0; depth < SCOPE_DEPTH; depth++)
+                symbol_table_exit_scope(table);
+        }
+        double scope_time = seconds_since(start) / rounds;
+
+        printf("%-10d %16.1f %16.1f %16.1f\n", count,
+               insert_time * 1e9 / count,
+               lookup_time * 1e9 / LOOKUPS,
+               scope_time * 1e9 / ((double)count * SCOPE_DEPTH));
+        if (found != LOOKUPS)
+            printf("  (lookup missed %ld names)\n", LOOKUPS - found);
+
+        region_release(REGION_SYMBOLS);
+    }
+
+    free(names);
+    intern_free();
+    return 0;
+}
\ No newline at end of file
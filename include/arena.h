@@ -0,0 +1,54 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+#include <stdio.h>
+
+// Bump-pointer region allocator. Memory is handed out from large blocks and
+// only ever released all at once with arena_release().
+typedef struct ArenaBlock
+{
+    struct ArenaBlock *next;
+    size_t used;
+    size_t size;
+    // allocations follow the header, aligned to ARENA_ALIGNMENT
+} ArenaBlock;
+
+typedef struct
+{
+    const char *name;
+    ArenaBlock *head; // block currently being filled
+    size_t used;      // bytes handed out since the last release
+    size_t reserved;  // bytes held in blocks
+    size_t peak_used;
+    size_t peak_reserved;
+} Arena;
+
+// One region per compiler phase; each is released when its phase's data is dead
+typedef enum
+{
+    REGION_TOKENS,  // lexer, token stream and parser state
+    REGION_AST,     // syntax tree
+    REGION_SYMBOLS, // symbol table and semantic diagnostics
+    REGION_IR,      // three-address code
+    REGION_OUTPUT,  // code generator state and assembly text
+    REGION_COUNT
+} RegionId;
+
+extern Arena regions[REGION_COUNT];
+
+void *arena_alloc(Arena *arena, size_t size);
+void *arena_calloc(Arena *arena, size_t count, size_t size);
+void *arena_grow(Arena *arena, void *ptr, size_t old_size, size_t new_size);
+char *arena_strdup(Arena *arena, const char *text);
+void arena_release(Arena *arena);
+
+void *region_alloc(RegionId region, size_t size);
+void *region_calloc(RegionId region, size_t count, size_t size);
+void *region_grow(RegionId region, void *ptr, size_t old_size, size_t new_size);
+char *region_strdup(RegionId region, const char *text);
+void region_release(RegionId region);
+void region_release_all(void);
+void region_report(FILE *out);
+
+#endif
\ No newline at end of file
@@ -1,6 +1,11 @@
 #ifndef AST_H
 #define AST_H
 
+#include <stddef.h>
+#include <stdint.h>
+#include "intern.h"
+#include "arena.h"
+
 typedef enum
 {
     // Expressions
@@ -28,103 +33,120 @@ typedef enum
     OP_GREATER,
     OP_ASSIGN
 } BinaryOpType;
-typedef struct
-{
-    int line;
-    int column;
-} NodeInfo;
-typedef struct
-{
-    BinaryOpType op;
-    Node *left;
-    Node *right;
-    NodeInfo info;
-} BinaryOpNode;
-typedef struct
-{
-    int value;
-    NodeInfo info;
-} NumberNode;
-typedef struct
-{
-    char *value;
-    NodeInfo info;
-} StringNode;
-typedef struct
-{
-    char *name;
-    NodeInfo info;
-} IdentifierNode;
-typedef struct
-{
-    char *name;
-    Node **arguments;
-    int arg_count;
-    NodeInfo info;
-} FunctionCallNode;
-typedef struct
-{
-    char *type;
-    char *name;
-    Node *initializer;
-    NodeInfo info;
-} VariableDeclarationNode;
-typedef struct
-{
-    Node *condition;
-    Node *if_body;
-    Node *else_body;
-    NodeInfo info;
-} IfStatementNode;
-typedef struct
-{
-    Node *initializer;
-    Node *condition;
-    Node *increment;
-    Node *body;
-    NodeInfo info;
-} ForLoopNode;
-typedef struct
+typedef enum
 {
-    Node **statements;
-    int count;
-    NodeInfo info;
-} BlockNode;
+    TYPE_NUM,
+    TYPE_STR,
+    TYPE_VOID
+} DataType;
+
+// Storage slot of a variable, assigned by semantic analysis; SLOT_NONE until then
+typedef uint32_t SlotId;
+
+#define SLOT_NONE 0
+
+// Nodes live in one array inside an Ast and refer to each other by index.
+// Index 0 is reserved so that NODE_NONE can mark a missing child.
+typedef uint32_t NodeId;
+
+#define NODE_NONE 0
+
+// Variable-length child lists (block statements, call arguments) are runs in
+// Ast.children: entries first .. first + count - 1
 typedef struct
 {
-    Node **statements;
-    int count;
-    NodeInfo info;
-} ProgramNode;
+    uint32_t first;
+    uint32_t count;
+} NodeList;
+
+// Every node is 24 bytes: a small header plus the per-kind record in the union.
+// offset is the source location as a byte offset; see source_location().
 struct Node
 {
-    NodeType type;
+    uint8_t type; // NodeType
+    uint8_t op;   // BinaryOpType, for NODE_BINARY_OP
+    uint8_t data_type; // DataType of an expression, recorded by semantic analysis
+    uint32_t offset;
     union
     {
-        NumberNode number;
-        StringNode string;
-        IdentifierNode identifier;
-        BinaryOpNode binary_op;
-        FunctionCallNode function_call;
-        VariableDeclarationNode var_decl;
-        IfStatementNode if_stmt;
-        ForLoopNode for_loop;
-        BlockNode block;
-        ProgramNode program;
+        int32_t number;
+        NameId string; // literal text without quotes
+        struct
+        {
+            NameId name;
+            SlotId slot;
+        } identifier;
+        struct
+        {
+            NodeId left;
+            NodeId right;
+        } binary_op;
+        struct
+        {
+            NameId name;
+            NodeList arguments;
+        } function_call;
+        struct
+        {
+            NameId type;
+            NameId name;
+            NodeId initializer;
+            SlotId slot;
+        } var_decl;
+        struct
+        {
+            NodeId condition;
+            NodeId if_body;
+            NodeId else_body;
+        } if_stmt;
+        struct
+        {
+            NodeId initializer;
+            NodeId condition;
+            NodeId increment;
+            NodeId body;
+        } for_loop;
+        NodeList block; // NODE_BLOCK and NODE_PROGRAM
     };
 };
 
+typedef struct
+{
+    Node *nodes;
+    uint32_t node_count;
+    uint32_t node_capacity;
+    NodeId *children;
+    uint32_t child_count;
+    uint32_t child_capacity;
+    NodeId root;
+    struct SlotTable *slots; // filled in by semantic analysis
+} Ast;
+
+// The tree and its arrays are allocated from REGION_AST
+Ast *create_ast(void);
+size_t ast_memory_usage(const Ast *ast);
+
+// Pointers returned by ast_node are invalidated by the next create_* call
+static inline Node *ast_node(const Ast *ast, NodeId id)
+{
+    return &ast->nodes[id];
+}
+
+static inline NodeId ast_child(const Ast *ast, NodeList list, uint32_t index)
+{
+    return ast->children[list.first + index];
+}
+
 // Function declarations for creating AST nodes
-Node *create_number_node(int value, int line, int column);
-Node *create_string_node(const char *value, int line, int column);
-Node *create_identifier_node(const char *name, int line, int column);
-Node *create_binary_op_node(BinaryOpType op, Node *left, Node *right, int line, int column);
-Node *create_function_call_node(const char *name, Node **arguments, int arg_count, int line, int column);
-Node *create_var_decl_node(const char *type, const char *name, Node *initializer, int line, int column);
-Node *create_if_node(Node *condition, Node *if_body, Node *else_body, int line, int column);
-Node *create_for_node(Node *initializer, Node *condition, Node *increment, Node *body, int line, int column);
-Node *create_block_node(Node **statements, int count, int line, int column);
-Node *create_program_node(Node **statements, int count);
-void free_node(Node *node);
+NodeId create_number_node(Ast *ast, int value, uint32_t offset);
+NodeId create_string_node(Ast *ast, NameId value, uint32_t offset);
+NodeId create_identifier_node(Ast *ast, NameId name, uint32_t offset);
+NodeId create_binary_op_node(Ast *ast, BinaryOpType op, NodeId left, NodeId right, uint32_t offset);
+NodeId create_function_call_node(Ast *ast, NameId name, const NodeId *arguments, int arg_count, uint32_t offset);
+NodeId create_var_decl_node(Ast *ast, NameId type, NameId name, NodeId initializer, uint32_t offset);
+NodeId create_if_node(Ast *ast, NodeId condition, NodeId if_body, NodeId else_body, uint32_t offset);
+NodeId create_for_node(Ast *ast, NodeId initializer, NodeId condition, NodeId increment, NodeId body, uint32_t offset);
+NodeId create_block_node(Ast *ast, const NodeId *statements, int count, uint32_t offset);
+NodeId create_program_node(Ast *ast, const NodeId *statements, int count);
 
-#endif
+#endif
\ No newline at end of file
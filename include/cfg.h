@@ -0,0 +1,57 @@
+#ifndef CFG_H
+#define CFG_H
+
+#include <stdio.h>
+#include "tac.h"
+
+// A maximal run of straight-line instructions: control enters at first and
+// leaves after last - 1. Jumps only target the first instruction of a block.
+typedef struct
+{
+    int first; // index into the TacBuffer
+    int last;  // one past the final instruction
+    int succs[2];
+    int succ_count; // a conditional branch has its target first, then the fallthrough
+    int *preds;
+    int pred_count;
+    int idom;  // immediate dominator; -1 for the entry and for unreachable blocks
+    int rpo;   // position in reverse postorder; -1 if unreachable from the entry
+    int loop;  // innermost loop containing the block, or -1
+} BasicBlock;
+
+// Natural loop of one header, merged over all of its back edges
+typedef struct
+{
+    int header;
+    int *blocks; // every block of the loop, header included, in block order
+    int block_count;
+    int *latches; // sources of the back edges
+    int latch_count;
+    int parent; // enclosing loop, or -1
+    int depth;  // 1 for an outermost loop
+} Loop;
+
+typedef struct
+{
+    const TacBuffer *tac;
+    BasicBlock *blocks; // in code order; block 0 is the entry
+    int block_count;
+    int *block_of; // block of every instruction
+    int *order;    // reachable blocks in reverse postorder
+    int order_count;
+    Loop *loops;   // outermost loops before the loops they contain
+    int loop_count;
+} Cfg;
+
+// Built from REGION_IR over the buffer as it is now; rebuild after changing
+// the code. NOP instructions must have been compacted away.
+Cfg *build_cfg(const TacBuffer *tac);
+bool cfg_dominates(const Cfg *cfg, int a, int b);
+bool cfg_loop_contains(const Cfg *cfg, int loop, int block);
+// The block just before the header, when it is the loop's only way in and
+// falls through into it; code placed in front of the header label then runs
+// once on entry. -1 otherwise.
+int cfg_preheader(const Cfg *cfg, int loop);
+void write_cfg_dot(const Cfg *cfg, FILE *out);
+
+#endif
\ No newline at end of file
@@ -1,30 +1,23 @@
 #ifndef GEN_H
 #define GEN_H
 
+#include <stdbool.h>
 #include "tac.h"
-typedef struct
-{
-    char *name;     
-    char *variable; 
-    bool is_free;   
-} Register;
+#include "regalloc.h"
 
 // Code generation context
 typedef struct
 {
-    Register *registers; 
-    int reg_count;       
-    int current_reg;     
+    const RegisterAllocation *allocation;
+    const char **addresses; // memory operand of each value kept in memory
     char *output;        
     int output_size;     
     int output_pos;      
 } GenContext;
 
+// The context and the assembly text it builds live in REGION_OUTPUT
 GenContext *create_gen_context(void);
-void free_gen_context(GenContext *context);
-char *generate_code(TAC *tac);
+char *generate_code(const TacBuffer *tac, const RegisterAllocation *allocation);
 void append_code(GenContext *context, const char *format, ...);
-Register *allocate_register(GenContext *context, const char *variable);
-void free_register(GenContext *context, Register *reg);
 
-#endif 
\ No newline at end of file
+#endif
\ No newline at end of file
@@ -0,0 +1,26 @@
+#ifndef INTERN_H
+#define INTERN_H
+
+#include <stdint.h>
+
+// Compiler-wide string interner. Every distinct name gets a small, stable integer
+// ID and one canonical NUL-terminated copy; later phases compare and hash IDs.
+typedef uint32_t NameId;
+
+#define NAME_NONE 0
+
+// Names every phase needs to recognise, interned up front in this order
+#define NAME_NUM 1
+#define NAME_STR 2
+#define NAME_SHOW 3
+#define NAME_ASK 4
+
+NameId intern(const char *text, int length);
+NameId intern_cstr(const char *text);
+NameId intern_find(const char *text, int length);
+const char *name_str(NameId id);
+int name_length(NameId id);
+uint32_t name_count(void);
+void intern_free(void);
+
+#endif
\ No newline at end of file
@@ -2,24 +2,38 @@
 #define LEXER_H
 
 #include "token.h"
+#include "source.h"
+#include "arena.h"
 
 typedef struct
 {
-    char *source;
+    SourceBuffer *buffer;
+    const char *source; // buffer->text: not owned and not NUL-terminated
+    int length;
     int position;
-    int line;
-    int column;
     char current_char;
 } Lexer;
 
-Lexer *create_lexer(char *source);
+// Contiguous, growable array of tokens produced in a single pass over the source.
+// The lexer and its tokens live in REGION_TOKENS.
+typedef struct
+{
+    Token *tokens;
+    int count;
+    int capacity;
+} TokenStream;
+
+Lexer *create_lexer(SourceBuffer *buffer);
 void lexer_advance(Lexer *lexer);
 void lexer_skip_whitespace(Lexer *lexer);
-Token *lexer_get_next_token(Lexer *lexer);
-Token *create_token(TokenType type, const char *value, int line, int column);
-char *lexer_collect_string(Lexer *lexer);
-char *lexer_collect_number(Lexer *lexer);
-char *lexer_collect_identifier(Lexer *lexer);
-void free_lexer(Lexer *lexer);
+Token lexer_get_next_token(Lexer *lexer);
+int lexer_collect_string(Lexer *lexer);
+int lexer_collect_number(Lexer *lexer);
+int lexer_collect_identifier(Lexer *lexer);
+
+TokenStream *create_token_stream(Lexer *lexer);
+
+const char *token_value(const Lexer *lexer, const Token *token, int *length);
+int token_to_int(const Lexer *lexer, const Token *token);
 
 #endif 
\ No newline at end of file
@@ -0,0 +1,37 @@
+#ifndef LIVENESS_H
+#define LIVENESS_H
+
+#include "cfg.h"
+
+// Storage values are numbered temps first, then variable slots: temp N is
+// value N and slot S is value temp_count + S. Sets are bitsets of words
+// 64-bit words, allocated from REGION_IR.
+typedef struct
+{
+    const Cfg *cfg;
+    int value_count;
+    int words;
+    uint64_t *live_in;  // per block: values read before any write on some path from its start
+    uint64_t *live_out; // per block: union of its successors' live_in
+} Liveness;
+
+// Value an operand reads or writes, or -1 for constants, labels and callees
+int liveness_value(const TacBuffer *tac, Operand operand);
+Liveness *compute_liveness(const Cfg *cfg);
+
+static inline bool liveness_contains(const uint64_t *set, int value)
+{
+    return (set[value / 64] >> (value % 64)) & 1;
+}
+
+static inline void liveness_add(uint64_t *set, int value)
+{
+    set[value / 64] |= (uint64_t)1 << (value % 64);
+}
+
+static inline void liveness_remove(uint64_t *set, int value)
+{
+    set[value / 64] &= ~((uint64_t)1 << (value % 64));
+}
+
+#endif
\ No newline at end of file
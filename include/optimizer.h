@@ -1 +1,56 @@
+#ifndef OPTIMIZER_H
+#define OPTIMIZER_H
 
+#include "tac.h"
+
+// Instruction counts around the pipeline, and how often each pass fired
+typedef struct
+{
+    int before;
+    int after;
+    int folded;     // constant expressions and branches evaluated at compile time
+    int propagated; // operands replaced by the value they copy
+    int unreachable;
+    int dead;       // temps computed but never used
+    int hoisted;    // loop-invariant computations moved in front of their loop
+    int reduced;    // products of an induction variable replaced by a running sum
+    int eliminated; // induction variables removed after their exit test was rewritten
+    int unrolled;   // loops fully or partially unrolled
+    int redundant;  // computations replaced by an earlier temp holding the same value
+    int rotated;    // loops whose test was moved below the body
+} OptimizerStats;
+
+typedef struct
+{
+    int level;         // -O level; 0 leaves the code untouched
+    int unroll_factor; // copies of the body per partially unrolled iteration; 0 disables unrolling
+    int unroll_budget; // instructions an unrolled loop body may grow to
+} OptimizerOptions;
+
+#define DEFAULT_UNROLL_FACTOR 4
+#define DEFAULT_UNROLL_BUDGET 64
+#define MAX_UNROLL_FACTOR 64
+#define MAX_UNROLL_BUDGET 4096
+
+// Rewrites the buffer in place. Scratch memory comes from REGION_IR.
+void optimize_tac(TacBuffer *tac, const OptimizerOptions *options, OptimizerStats *stats);
+void print_optimizer_stats(const OptimizerStats *stats);
+
+// Helpers shared by the passes
+bool tac_is_binary(TACOpType op);
+bool tac_is_pure(const TAC *tac);
+bool tac_evaluate(TACOpType op, int64_t a, int64_t b, int64_t *value);
+bool tac_induction_step(const TAC *tac, int64_t *step);
+bool tac_constant_before(const TacBuffer *tac, int first, int last, SlotId var, int64_t *value);
+
+// Passes kept in their own files; each returns the number of instructions it changed
+int propagate_constants(TacBuffer *tac, OptimizerStats *stats); // sccp.c
+int hoist_invariants(TacBuffer *tac, OptimizerStats *stats);    // licm.c
+int reduce_induction(TacBuffer *tac, OptimizerStats *stats);    // induction.c
+int number_values(TacBuffer *tac, OptimizerStats *stats);       // gvn.c
+
+// Run once, after the other passes settle; the pipeline then cleans up the copies
+int unroll_loops(TacBuffer *tac, const OptimizerOptions *options, OptimizerStats *stats); // unroll.c
+int rotate_loops(TacBuffer *tac, OptimizerStats *stats);                                  // rotate.c
+
+#endif
\ No newline at end of file
@@ -8,22 +8,27 @@
 typedef struct
 {
     Lexer *lexer;
+    TokenStream *tokens;
+    int position;
     Token *current_token;
+    Ast *ast;         // tree under construction
+    NodeId *scratch;  // statements of the blocks currently open, innermost last
+    int scratch_count;
+    int scratch_capacity;
 } Parser;
 
 Parser *create_parser(Lexer *lexer);
 void parser_advance(Parser *parser);
 bool parser_expect(Parser *parser, TokenType type);
-void free_parser(Parser *parser);
-Node *parse_program(Parser *parser);
-Node *parse_statement(Parser *parser);
-Node *parse_variable_declaration(Parser *parser);
-Node *parse_if_statement(Parser *parser);
-Node *parse_for_loop(Parser *parser);
-Node *parse_function_call(Parser *parser, Token *func_token);
-Node *parse_expression(Parser *parser);
-Node *parse_term(Parser *parser);
-Node *parse_factor(Parser *parser);
-Node *parse_primary(Parser *parser);
+Ast *parse_program(Parser *parser);
+NodeId parse_statement(Parser *parser);
+NodeId parse_variable_declaration(Parser *parser);
+NodeId parse_if_statement(Parser *parser);
+NodeId parse_for_loop(Parser *parser);
+NodeId parse_function_call(Parser *parser, Token *func_token);
+NodeId parse_expression(Parser *parser);
+NodeId parse_term(Parser *parser);
+NodeId parse_factor(Parser *parser);
+NodeId parse_primary(Parser *parser);
 
 #endif // PARSER_H
\ No newline at end of file
@@ -0,0 +1,72 @@
+#ifndef REGALLOC_H
+#define REGALLOC_H
+
+#include "liveness.h"
+
+// Registers handed out to temps and variables. rax, rcx and rdx are kept for
+// code generation: arithmetic results, show's argument and division.
+typedef enum
+{
+    // Clobbered by calls under the win64 ABI, like rax, rcx and rdx
+    REG_R8,
+    REG_R9,
+    REG_R10,
+    REG_R11,
+    // Preserved across calls
+    REG_RBX,
+    REG_RSI,
+    REG_RDI,
+    REG_R12,
+    REG_R13,
+    REG_R14,
+    REG_R15,
+    REG_COUNT
+} MachineRegister;
+
+#define REG_NONE (-1)
+
+typedef struct
+{
+    const char *name;
+    bool preserved; // callee-saved, so a value may stay in it across show calls
+} Register;
+
+extern const Register machine_registers[REG_COUNT];
+
+// Values kept in memory share 8-byte slots of the stack frame. The frame stays
+// within one 4 KB page so the prologue needs no stack probe; values beyond it
+// get their own cell in .bss.
+#define MAX_FRAME_SLOTS 500
+#define FRAME_SLOT_NONE (-1)   // in a register, or never read or written
+#define FRAME_SLOT_GLOBAL (-2) // in .bss
+
+// Where each storage value (numbered as in liveness.h) lives for the whole program
+typedef struct
+{
+    int value_count;
+    int *location;  // MachineRegister, or REG_NONE to keep the value in memory
+    int *slot;      // frame slot of a value kept in memory, counted down from rbp, or FRAME_SLOT_*
+    int frame_slots;
+    int globals;    // values in .bss
+    int allocated;  // values given a register
+    int spilled;    // values that wanted one and were left in memory
+    int coalesced;  // copies whose source and destination share a register
+} RegisterAllocation;
+
+typedef enum
+{
+    REGALLOC_LINEAR,   // default at -O1
+    REGALLOC_COLORING, // default at -O2 and above
+} RegisterAllocator;
+
+// All allocate from REGION_IR
+RegisterAllocation *allocate_stack_frame(const TacBuffer *tac);     // regalloc.c, every value in memory
+RegisterAllocation *allocate_linear_scan(const TacBuffer *tac);     // regalloc.c
+RegisterAllocation *allocate_graph_coloring(const TacBuffer *tac);  // coloring.c
+
+// Shared by the allocators
+RegisterAllocation *create_allocation(int value_count);
+int64_t block_weight(const Cfg *cfg, int block); // 10 per enclosing loop, capped
+void assign_frame_slots(const Liveness *liveness, RegisterAllocation *allocation);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,30 @@
+#ifndef SCAN_H
+#define SCAN_H
+
+#include <stddef.h>
+
+// Bulk scanners used by the lexer. Each returns the number of bytes, starting at
+// text, before the first byte that ends the run (or length if none does).
+typedef enum
+{
+    SCAN_SCALAR,
+    SCAN_SSE2,
+    SCAN_AVX2
+} ScanImpl;
+
+typedef struct
+{
+    size_t (*whitespace)(const char *text, size_t length);  // run of isspace() bytes
+    size_t (*line)(const char *text, size_t length);        // up to '\n' or '\0'
+    size_t (*identifier)(const char *text, size_t length);  // run of [A-Za-z0-9_]
+    size_t (*string_body)(const char *text, size_t length); // up to '"' or '\0'
+} ScanFunctions;
+
+extern ScanFunctions scanner;
+
+void scan_init(void);
+ScanImpl scan_best_impl(void);
+void scan_select(ScanImpl impl);
+const char *scan_impl_name(ScanImpl impl);
+
+#endif
\ No newline at end of file
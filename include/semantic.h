@@ -16,22 +16,24 @@ typedef struct
 {
     SemanticErrorType type;
     char *message;
-    int line;
-    int column;
+    uint32_t offset;
 } SemanticError;
 typedef struct
 {
+    Ast *ast;
     SymbolTable *symbol_table;
+    SlotTable *slots; // storage assigned to each declaration; outlives the context
     SemanticError *errors;
     int error_count;
     int error_capacity;
 } SemanticContext;
+// The context, its symbol table and its diagnostics live in REGION_SYMBOLS
 SemanticContext *create_semantic_context(void);
-void free_semantic_context(SemanticContext *context);
-bool analyze_program(SemanticContext *context, Node *program);
-DataType get_expression_type(SemanticContext *context, Node *expr);
+bool analyze_program(SemanticContext *context, Ast *ast);
+// Type-checks an expression once and records its DataType on the node
+DataType get_expression_type(SemanticContext *context, NodeId expr);
 void add_semantic_error(SemanticContext *context, SemanticErrorType type,
-                        const char *message, int line, int column);
+                        const char *message, uint32_t offset);
 const char *get_error_type_string(SemanticErrorType type);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,31 @@
+#ifndef SOURCE_H
+#define SOURCE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef enum
+{
+    SOURCE_MAPPED,  // read-only mapping of a regular file
+    SOURCE_STREAMED // read in chunks from a pipe or stdin
+} SourceKind;
+
+// The one and only copy of the program text; the lexer and every later phase
+// point into it. The text is not NUL-terminated when mapped.
+typedef struct
+{
+    const char *text;
+    size_t length;
+    SourceKind kind;
+    void *mapping; // platform handle for SOURCE_MAPPED, NULL otherwise
+
+    // Offsets of the first byte of every line, built on the first location lookup
+    uint32_t *line_starts;
+    int line_count;
+} SourceBuffer;
+
+SourceBuffer *source_open(const char *filename);
+void source_close(SourceBuffer *source);
+void source_location(SourceBuffer *source, uint32_t offset, int *line, int *column);
+
+#endif
\ No newline at end of file
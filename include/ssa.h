@@ -0,0 +1,42 @@
+#ifndef SSA_H
+#define SSA_H
+
+#include "cfg.h"
+
+// SSA is kept beside the code rather than in it: operands still name their
+// variable, and each one is tagged with the value (the variable's version) it
+// reads or writes. Temps are already assigned once, so temp N is value N.
+// Leaving SSA is dropping these tables, which is sound as long as a pass only
+// replaces uses with constants and removes code, never overlapping two
+// versions of one variable.
+typedef struct
+{
+    int block;
+    SlotId var;
+    int value;
+    int *args; // incoming value per predecessor, in the block's pred order; -1 if none
+    int next;  // next phi of the same block, or -1
+} Phi;
+
+typedef struct
+{
+    const Cfg *cfg;
+    int value_count;
+    int *def_value; // value written by each instruction, or -1
+    int *use_value; // values read by arg1 and arg2 of each instruction, or -1
+    Phi *phis;
+    int phi_count;
+    int *block_phis; // first phi of each block, or -1
+    SlotId *value_var; // variable each value is a version of; SLOT_NONE for temps
+    int *pred_edge;  // per block and pred position: pred * 2 + succ index of the edge
+    int *pred_start; // offset of each block's entries in pred_edge
+} Ssa;
+
+// Values of the form temp_count + slot hold a variable's contents on entry
+#define SSA_ENTRY_VALUE(tac, slot) ((int)(tac)->temp_count + (int)(slot))
+
+// Phis go at the iterated dominance frontier of each variable's definitions;
+// tables are allocated from REGION_IR
+Ssa *build_ssa(const Cfg *cfg);
+
+#endif
\ No newline at end of file
@@ -2,42 +2,84 @@
 #define SYMBOL_TABLE_H
 
 #include <stdbool.h>
+#include "intern.h"
+#include "arena.h"
+#include "ast.h"
 typedef enum
 {
     SYMBOL_VARIABLE,
     SYMBOL_FUNCTION
 } SymbolType;
 
-typedef enum
-{
-    TYPE_NUM,
-    TYPE_STR,
-    TYPE_VOID
-} DataType;
+// Symbols are stored inline in a stack ordered by declaration, which doubles
+// as the undo log for scope exit
 typedef struct Symbol
 {
-    char *name;
+    NameId name;
     SymbolType symbol_type;
     DataType data_type;
     bool is_initialized;
     int scope_level;
-    struct Symbol *next; 
+    int shadowed; // index of the outer binding of the same name, or -1
+    SlotId slot;
 } Symbol;
 
+// Open-addressing slot: a name and the index of its innermost live binding (-1 if none)
+typedef struct
+{
+    NameId name;
+    int symbol;
+} SymbolSlot;
+
 typedef struct SymbolTable
 {
-    Symbol **symbols; 
-    int size;         
-    int scope_level;  
+    SymbolSlot *slots; // linear probing, power-of-two capacity; NAME_NONE marks an empty slot
+    uint32_t capacity;
+    uint32_t used;     // occupied slots
+    int shift;         // 32 - log2(capacity), for Fibonacci hashing of NameIds
+    Symbol *symbols;
+    int symbol_count;
+    int symbol_capacity;
+    int *scope_starts; // symbol_count at each enter_scope, innermost last
+    int scope_capacity;
+    int scope_level;
 } SymbolTable;
 
+// Storage for declared variables. Each live declaration owns a distinct slot;
+// a slot is only handed out again, to a declaration of the same name and type,
+// once the scope that declared it has been exited.
+typedef struct
+{
+    NameId name;
+    NameId label; // unique assembly label: the name itself, or name_N when shadowed
+    DataType type;
+    bool live;
+    SlotId next_same_name;
+} VarSlot;
+
+typedef struct SlotTable
+{
+    VarSlot *slots; // indexed by SlotId; entry 0 backs SLOT_NONE
+    uint32_t count;
+    uint32_t capacity;
+    SlotId *by_name; // most recent slot for each NameId, chained via next_same_name
+    uint32_t name_capacity;
+} SlotTable;
+
+// Slots outlive the symbol table: they are allocated from REGION_IR, for TAC and codegen
+SlotTable *create_slot_table(void);
+SlotId slot_table_bind(SlotTable *slots, NameId name, DataType type);
+void slot_table_release(SlotTable *slots, SlotId slot);
+
+// Tables and their symbols are allocated from REGION_SYMBOLS. size is a hint for
+// the number of names; the table grows as needed. Symbol pointers returned by
+// lookup stay valid until the next insert.
 SymbolTable *create_symbol_table(int size);
-void free_symbol_table(SymbolTable *table);
-bool symbol_table_insert(SymbolTable *table, const char *name, SymbolType sym_type, DataType data_type);
-Symbol *symbol_table_lookup(SymbolTable *table, const char *name);
+bool symbol_table_insert(SymbolTable *table, NameId name, SymbolType sym_type, DataType data_type);
+Symbol *symbol_table_lookup(SymbolTable *table, NameId name);
 void symbol_table_enter_scope(SymbolTable *table);
 void symbol_table_exit_scope(SymbolTable *table);
-void symbol_table_set_initialized(SymbolTable *table, const char *name);
+void symbol_table_set_initialized(SymbolTable *table, NameId name);
 void print_symbol_table(SymbolTable *table);
 
 #endif 
\ No newline at end of file
@@ -3,6 +3,8 @@
 
 #include <stdbool.h>
 #include "ast.h"
+#include "intern.h"
+#include "symbol_table.h"
 
 typedef enum
 {
@@ -31,32 +33,89 @@ typedef enum
     TAC_GREATER,    // Greater than
     TAC_GREATER_EQ, // Greater than or equal
     TAC_EQ,         // Equal
-    TAC_NEQ         // Not equal
+    TAC_NEQ,        // Not equal
+    TAC_NOP         // removed by an optimization pass, until the buffer is compacted
 } TACOpType;
 
+typedef enum
+{
+    OPERAND_NONE,   // unused
+    OPERAND_TEMP,   // compiler temporary, numbered per program
+    OPERAND_VAR,    // variable storage slot
+    OPERAND_IMM,    // integer immediate
+    OPERAND_STRING, // string literal, by its interned text
+    OPERAND_LABEL,  // jump target, numbered per program
+    OPERAND_FUNC    // callee, by its interned name
+} OperandKind;
+
+// Operands are stored inline; only format_tac and the code generator turn them into text
+typedef struct
+{
+    OperandKind kind;
+    union
+    {
+        uint32_t id; // temp or label number, SlotId, or NameId
+        int64_t imm;
+    };
+} Operand;
+
+static inline Operand make_operand(OperandKind kind, uint32_t id)
+{
+    Operand operand;
+    operand.kind = kind;
+    operand.imm = 0;
+    operand.id = id;
+    return operand;
+}
+
+static inline Operand make_imm(int64_t value)
+{
+    Operand operand;
+    operand.kind = OPERAND_IMM;
+    operand.imm = value;
+    return operand;
+}
+
+static inline bool operand_equal(Operand a, Operand b)
+{
+    return a.kind == b.kind && (a.kind == OPERAND_IMM ? a.imm == b.imm : a.id == b.id);
+}
+
+#define NO_OPERAND make_operand(OPERAND_NONE, 0)
+
 typedef struct TAC
 {
     TACOpType op;
-    char *result; 
-    char *arg1;   
-    char *arg2;   
-    struct TAC *next;
-    int line; 
+    Operand result; // for jumps and labels, the label
+    Operand arg1;
+    Operand arg2;
+    uint32_t offset; // source location of the originating node
+    DataType type;   // type of the value computed; for a call without a result, of its argument
 } TAC;
 
-TAC *tac_create(TACOpType op, char *result, char *arg1, char *arg2, int line);
-void tac_free(TAC *tac);
-TAC *tac_join(TAC *tac1, TAC *tac2);
-TAC *ast_to_tac(Node *node);
-TAC *generate_tac_for_expr(Node *node);
-TAC *generate_tac_for_stmt(Node *node);
-TAC *generate_tac_for_decl(Node *node);
-char *generate_temp_var(void);
-char *generate_label(void);
-void reset_temp_counter(void);
-void reset_label_counter(void);
-void print_tac(TAC *tac);
-void print_tac_list(TAC *tac);
+// Instructions are stored contiguously in program order, so passes can index them
+typedef struct
+{
+    TAC *code;
+    int count;
+    int capacity;
+    uint32_t temp_count;
+    uint32_t label_count;
+    SlotTable *slots; // storage behind every OPERAND_VAR
+} TacBuffer;
+
+// The buffer lives in REGION_IR and is released with it
+TacBuffer *create_tac_buffer(SlotTable *slots);
+TAC *tac_emit(TacBuffer *buffer, TACOpType op, Operand result, Operand arg1, Operand arg2, uint32_t offset);
+TacBuffer *ast_to_tac(const Ast *ast);
+Operand generate_tac_for_expr(TacBuffer *out, const Ast *ast, NodeId id);
+void generate_tac_for_stmt(TacBuffer *out, const Ast *ast, NodeId id);
+Operand generate_temp_var(TacBuffer *out);
+Operand generate_label(TacBuffer *out);
+#define TAC_TEXT_SIZE 512
+size_t format_tac(char *buffer, size_t size, const TAC *tac, const SlotTable *slots);
+void print_tac(const TAC *tac, const SlotTable *slots);
+void print_tac_list(const TacBuffer *tac);
 void test_tac_generation(void);
 
 #endif
\ No newline at end of file
@@ -1,5 +1,8 @@
 #ifndef TOKEN_H
 #define TOKEN_H
+
+#include <stdint.h>
+
 typedef enum
 {
     // Data types
@@ -31,12 +34,24 @@ typedef enum
     TOKEN_EOF
 } TokenType;
 
+// A token is a span of the source buffer; no text is copied while lexing
 typedef struct
 {
     TokenType type;
-    char *value;
-    int line;
-    int column;
+    uint32_t offset; // start of the lexeme in the source, also its location
+    uint32_t length; // lexeme length in bytes (string literals include their quotes)
 } Token;
 
+typedef struct
+{
+    const char *name;    // display name used in diagnostics
+    const char *keyword; // source spelling, NULL for non-keywords
+    int keyword_length;
+} TokenInfo;
+
+extern const TokenInfo token_info[TOKEN_EOF + 1];
+
+TokenType keyword_lookup(const char *text, int length);
+const char *token_type_to_string(TokenType type);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,157 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../include/arena.h"
+
+#define ARENA_BLOCK_SIZE 65536
+#define ARENA_ALIGNMENT 16
+#define ALIGN_UP(n) (((n) + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1))
+#define BLOCK_HEADER ALIGN_UP(sizeof(ArenaBlock))
+
+Arena regions[REGION_COUNT] = {
+    {.name = "tokens"},
+    {.name = "ast"},
+    {.name = "symbols"},
+    {.name = "ir"},
+    {.name = "output"},
+};
+
+static char *block_data(ArenaBlock *block)
+{
+    return (char *)block + BLOCK_HEADER;
+}
+
+static void new_block(Arena *arena, size_t size)
+{
+    size_t capacity = size > ARENA_BLOCK_SIZE ? ALIGN_UP(size) : ARENA_BLOCK_SIZE;
+    ArenaBlock *block = (ArenaBlock *)malloc(BLOCK_HEADER + capacity);
+    if (!block)
+    {
+        fprintf(stderr, "Error: Memory allocation failed for %s region\n", arena->name);
+        exit(1);
+    }
+    block->next = arena->head;
+    block->used = 0;
+    block->size = capacity;
+    arena->head = block;
+
+    arena->reserved += BLOCK_HEADER + capacity;
+    if (arena->reserved > arena->peak_reserved)
+        arena->peak_reserved = arena->reserved;
+}
+
+void *arena_alloc(Arena *arena, size_t size)
+{
+    size = ALIGN_UP(size ? size : 1);
+    if (!arena->head || arena->head->size - arena->head->used < size)
+        new_block(arena, size);
+
+    void *ptr = block_data(arena->head) + arena->head->used;
+    arena->head->used += size;
+
+    arena->used += size;
+    if (arena->used > arena->peak_used)
+        arena->peak_used = arena->used;
+    return ptr;
+}
+
+void *arena_calloc(Arena *arena, size_t count, size_t size)
+{
+    void *ptr = arena_alloc(arena, count * size);
+    memset(ptr, 0, count * size);
+    return ptr;
+}
+
+// Resize an allocation. The most recent allocation grows in place when its block
+// has room; anything else is copied and the old bytes stay until release.
+void *arena_grow(Arena *arena, void *ptr, size_t old_size, size_t new_size)
+{
+    if (!ptr)
+        return arena_alloc(arena, new_size);
+
+    ArenaBlock *block = arena->head;
+    size_t old_aligned = ALIGN_UP(old_size ? old_size : 1);
+    size_t new_aligned = ALIGN_UP(new_size ? new_size : 1);
+    if (block && (char *)ptr + old_aligned == block_data(block) + block->used &&
+        block->used - old_aligned + new_aligned <= block->size)
+    {
+        block->used = block->used - old_aligned + new_aligned;
+        arena->used = arena->used - old_aligned + new_aligned;
+        if (arena->used > arena->peak_used)
+            arena->peak_used = arena->used;
+        return ptr;
+    }
+
+    void *result = arena_alloc(arena, new_size);
+    memcpy(result, ptr, old_size < new_size ? old_size : new_size);
+    return result;
+}
+
+char *arena_strdup(Arena *arena, const char *text)
+{
+    size_t length = strlen(text) + 1;
+    char *copy = (char *)arena_alloc(arena, length);
+    memcpy(copy, text, length);
+    return copy;
+}
+
+// Free every block at once; the peak counters survive for reporting
+void arena_release(Arena *arena)
+{
+    ArenaBlock *block = arena->head;
+    while (block)
+    {
+        ArenaBlock *next = block->next;
+        free(block);
+        block = next;
+    }
+    arena->head = NULL;
+    arena->used = 0;
+    arena->reserved = 0;
+}
+
+void *region_alloc(RegionId region, size_t size)
+{
+    return arena_alloc(&regions[region], size);
+}
+
+void *region_calloc(RegionId region, size_t count, size_t size)
+{
+    return arena_calloc(&regions[region], count, size);
+}
+
+void *region_grow(RegionId region, void *ptr, size_t old_size, size_t new_size)
+{
+    return arena_grow(&regions[region], ptr, old_size, new_size);
+}
+
+char *region_strdup(RegionId region, const char *text)
+{
+    return arena_strdup(&regions[region], text);
+}
+
+void region_release(RegionId region)
+{
+    arena_release(&regions[region]);
+}
+
+void region_release_all(void)
+{
+    for (int i = 0; i < REGION_COUNT; i++)
+        arena_release(&regions[i]);
+}
+
+void region_report(FILE *out)
+{
+    size_t total_used = 0;
+    size_t total_reserved = 0;
+
+    fprintf(out, "%-10s %14s %14s\n", "Region", "Peak used", "Peak reserved");
+    for (int i = 0; i < REGION_COUNT; i++)
+    {
+        fprintf(out, "%-10s %14zu %14zu\n", regions[i].name, regions[i].peak_used, regions[i].peak_reserved);
+        total_used += regions[i].peak_used;
+        total_reserved += regions[i].peak_reserved;
+    }
+    fprintf(out, "%-10s %14zu %14zu\n", "total", total_used, total_reserved);
+}
\ No newline at end of file
@@ -3,210 +3,155 @@
 #include <string.h>
 #include "../include/ast.h"
 
-// Helper function to allocate a new node
-static Node *create_node(NodeType type)
+#define INITIAL_NODE_CAPACITY 256
+#define INITIAL_CHILD_CAPACITY 256
+
+Ast *create_ast(void)
 {
-    Node *node = (Node *)malloc(sizeof(Node));
-    node->type = type;
-    return node;
+    Ast *ast = (Ast *)region_alloc(REGION_AST, sizeof(Ast));
+    ast->node_capacity = INITIAL_NODE_CAPACITY;
+    ast->nodes = (Node *)region_alloc(REGION_AST, ast->node_capacity * sizeof(Node));
+    ast->child_capacity = INITIAL_CHILD_CAPACITY;
+    ast->children = (NodeId *)region_alloc(REGION_AST, ast->child_capacity * sizeof(NodeId));
+    ast->child_count = 0;
+    ast->root = NODE_NONE;
+    ast->slots = NULL;
+
+    // Slot 0 backs NODE_NONE and is never handed out
+    memset(&ast->nodes[0], 0, sizeof(Node));
+    ast->node_count = 1;
+    return ast;
 }
 
-Node *create_number_node(int value, int line, int column)
+size_t ast_memory_usage(const Ast *ast)
 {
-    Node *node = create_node(NODE_NUMBER);
-    node->number.value = value;
-    node->number.info.line = line;
-    node->number.info.column = column;
-    return node;
+    return sizeof(Ast) + ast->node_capacity * sizeof(Node) + ast->child_capacity * sizeof(NodeId);
 }
 
-Node *create_string_node(const char *value, int line, int column)
+// Helper function to append a new node
+static NodeId create_node(Ast *ast, NodeType type, uint32_t offset)
 {
-    Node *node = create_node(NODE_STRING);
-    node->string.value = strdup(value);
-    node->string.info.line = line;
-    node->string.info.column = column;
-    return node;
+    if (ast->node_count >= ast->node_capacity)
+    {
+        ast->nodes = (Node *)region_grow(REGION_AST, ast->nodes, ast->node_capacity * sizeof(Node),
+                                         ast->node_capacity * 2 * sizeof(Node));
+        ast->node_capacity *= 2;
+    }
+
+    NodeId id = ast->node_count++;
+    Node *node = &ast->nodes[id];
+    memset(node, 0, sizeof(Node));
+    node->type = (uint8_t)type;
+    node->offset = offset;
+    return id;
 }
 
-Node *create_identifier_node(const char *name, int line, int column)
+// Copy a child list into the shared side array
+static NodeList create_list(Ast *ast, const NodeId *items, int count)
 {
-    Node *node = create_node(NODE_IDENTIFIER);
-    node->identifier.name = strdup(name);
-    node->identifier.info.line = line;
-    node->identifier.info.column = column;
-    return node;
+    NodeList list;
+    if (ast->child_count + (uint32_t)count > ast->child_capacity)
+    {
+        uint32_t capacity = ast->child_capacity;
+        while (ast->child_count + (uint32_t)count > capacity)
+            capacity *= 2;
+        ast->children = (NodeId *)region_grow(REGION_AST, ast->children, ast->child_capacity * sizeof(NodeId),
+                                              capacity * sizeof(NodeId));
+        ast->child_capacity = capacity;
+    }
+
+    list.first = ast->child_count;
+    list.count = (uint32_t)count;
+    if (count > 0)
+        memcpy(&ast->children[list.first], items, count * sizeof(NodeId));
+    ast->child_count += (uint32_t)count;
+    return list;
 }
 
-Node *create_binary_op_node(BinaryOpType op, Node *left, Node *right, int line, int column)
+NodeId create_number_node(Ast *ast, int value, uint32_t offset)
 {
-    Node *node = create_node(NODE_BINARY_OP);
-    node->binary_op.op = op;
-    node->binary_op.left = left;
-    node->binary_op.right = right;
-    node->binary_op.info.line = line;
-    node->binary_op.info.column = column;
-    return node;
+    NodeId id = create_node(ast, NODE_NUMBER, offset);
+    ast->nodes[id].number = value;
+    return id;
+}
+
+NodeId create_string_node(Ast *ast, NameId value, uint32_t offset)
+{
+    NodeId id = create_node(ast, NODE_STRING, offset);
+    ast->nodes[id].string = value;
+    return id;
 }
 
-Node *create_function_call_node(const char *name, Node **arguments, int arg_count, int line, int column)
+NodeId create_identifier_node(Ast *ast, NameId name, uint32_t offset)
 {
-    Node *node = create_node(NODE_FUNCTION_CALL);
-    node->function_call.name = strdup(name);
-    node->function_call.arg_count = arg_count;
-    node->function_call.info.line = line;
-    node->function_call.info.column = column;
+    NodeId id = create_node(ast, NODE_IDENTIFIER, offset);
+    ast->nodes[id].identifier.name = name;
+    return id;
+}
 
-    if (arg_count > 0)
-    {
-        node->function_call.arguments = (Node **)malloc(sizeof(Node *) * arg_count);
-        memcpy(node->function_call.arguments, arguments, sizeof(Node *) * arg_count);
-    }
-    else
-    {
-        node->function_call.arguments = NULL;
-    }
+NodeId create_binary_op_node(Ast *ast, BinaryOpType op, NodeId left, NodeId right, uint32_t offset)
+{
+    NodeId id = create_node(ast, NODE_BINARY_OP, offset);
+    Node *node = &ast->nodes[id];
+    node->op = (uint8_t)op;
+    node->binary_op.left = left;
+    node->binary_op.right = right;
+    return id;
+}
 
-    return node;
+NodeId create_function_call_node(Ast *ast, NameId name, const NodeId *arguments, int arg_count, uint32_t offset)
+{
+    NodeList list = create_list(ast, arguments, arg_count);
+    NodeId id = create_node(ast, NODE_FUNCTION_CALL, offset);
+    ast->nodes[id].function_call.name = name;
+    ast->nodes[id].function_call.arguments = list;
+    return id;
 }
 
-Node *create_var_decl_node(const char *type, const char *name, Node *initializer, int line, int column)
+NodeId create_var_decl_node(Ast *ast, NameId type, NameId name, NodeId initializer, uint32_t offset)
 {
-    Node *node = create_node(NODE_VARIABLE_DECLARATION);
-    node->var_decl.type = strdup(type);
-    node->var_decl.name = strdup(name);
+    NodeId id = create_node(ast, NODE_VARIABLE_DECLARATION, offset);
+    Node *node = &ast->nodes[id];
+    node->var_decl.type = type;
+    node->var_decl.name = name;
     node->var_decl.initializer = initializer;
-    node->var_decl.info.line = line;
-    node->var_decl.info.column = column;
-    return node;
+    return id;
 }
 
-Node *create_if_node(Node *condition, Node *if_body, Node *else_body, int line, int column)
+NodeId create_if_node(Ast *ast, NodeId condition, NodeId if_body, NodeId else_body, uint32_t offset)
 {
-    Node *node = create_node(NODE_IF_STATEMENT);
+    NodeId id = create_node(ast, NODE_IF_STATEMENT, offset);
+    Node *node = &ast->nodes[id];
     node->if_stmt.condition = condition;
     node->if_stmt.if_body = if_body;
     node->if_stmt.else_body = else_body;
-    node->if_stmt.info.line = line;
-    node->if_stmt.info.column = column;
-    return node;
+    return id;
 }
 
-Node *create_for_node(Node *initializer, Node *condition, Node *increment, Node *body, int line, int column)
+NodeId create_for_node(Ast *ast, NodeId initializer, NodeId condition, NodeId increment, NodeId body, uint32_t offset)
 {
-    Node *node = create_node(NODE_FOR_LOOP);
+    NodeId id = create_node(ast, NODE_FOR_LOOP, offset);
+    Node *node = &ast->nodes[id];
     node->for_loop.initializer = initializer;
     node->for_loop.condition = condition;
     node->for_loop.increment = increment;
     node->for_loop.body = body;
-    node->for_loop.info.line = line;
-    node->for_loop.info.column = column;
-    return node;
-}
-
-Node *create_block_node(Node **statements, int count, int line, int column)
-{
-    Node *node = create_node(NODE_BLOCK);
-    node->block.count = count;
-    node->block.info.line = line;
-    node->block.info.column = column;
-
-    if (count > 0)
-    {
-        node->block.statements = (Node **)malloc(sizeof(Node *) * count);
-        memcpy(node->block.statements, statements, sizeof(Node *) * count);
-    }
-    else
-    {
-        node->block.statements = NULL;
-    }
-
-    return node;
+    return id;
 }
 
-Node *create_program_node(Node **statements, int count)
+NodeId create_block_node(Ast *ast, const NodeId *statements, int count, uint32_t offset)
 {
-    Node *node = create_node(NODE_PROGRAM);
-    node->program.count = count;
-    node->program.info.line = 1;
-    node->program.info.column = 1;
-
-    if (count > 0)
-    {
-        node->program.statements = (Node **)malloc(sizeof(Node *) * count);
-        memcpy(node->program.statements, statements, sizeof(Node *) * count);
-    }
-    else
-    {
-        node->program.statements = NULL;
-    }
-
-    return node;
+    NodeList list = create_list(ast, statements, count);
+    NodeId id = create_node(ast, NODE_BLOCK, offset);
+    ast->nodes[id].block = list;
+    return id;
 }
 
-void free_node(Node *node)
+NodeId create_program_node(Ast *ast, const NodeId *statements, int count)
 {
-    if (!node)
-        return;
-
-    switch (node->type)
-    {
-    case NODE_STRING:
-        free(node->string.value);
-        break;
-
-    case NODE_IDENTIFIER:
-        free(node->identifier.name);
-        break;
-
-    case NODE_BINARY_OP:
-        free_node(node->binary_op.left);
-        free_node(node->binary_op.right);
-        break;
-
-    case NODE_FUNCTION_CALL:
-        free(node->function_call.name);
-        for (int i = 0; i < node->function_call.arg_count; i++)
-        {
-            free_node(node->function_call.arguments[i]);
-        }
-        free(node->function_call.arguments);
-        break;
-
-    case NODE_VARIABLE_DECLARATION:
-        free(node->var_decl.type);
-        free(node->var_decl.name);
-        free_node(node->var_decl.initializer);
-        break;
-
-    case NODE_IF_STATEMENT:
-        free_node(node->if_stmt.condition);
-        free_node(node->if_stmt.if_body);
-        if (node->if_stmt.else_body)
-        {
-            free_node(node->if_stmt.else_body);
-        }
-        break;
-
-    case NODE_FOR_LOOP:
-        free_node(node->for_loop.initializer);
-        free_node(node->for_loop.condition);
-        free_node(node->for_loop.increment);
-        free_node(node->for_loop.body);
-        break;
-
-    case NODE_BLOCK:
-    case NODE_PROGRAM:
-        for (int i = 0; i < node->block.count; i++)
-        {
-            free_node(node->block.statements[i]);
-        }
-        free(node->block.statements);
-        break;
-
-    default:
-        break;
-    }
-
-    free(node);
+    NodeList list = create_list(ast, statements, count);
+    NodeId id = create_node(ast, NODE_PROGRAM, 0);
+    ast->nodes[id].block = list;
+    ast->root = id;
+    return id;
 }
\ No newline at end of file
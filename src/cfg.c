@@ -0,0 +1,377 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../include/cfg.h"
+
+static bool ends_block(TACOpType op)
+{
+    return op == TAC_IF || op == TAC_GOTO;
+}
+
+// Leaders are the first instruction, every label, and whatever follows a jump
+static void split_blocks(Cfg *cfg)
+{
+    const TacBuffer *tac = cfg->tac;
+    int count = 0;
+    for (int i = 0; i < tac->count; i++)
+    {
+        if (i == 0 || tac->code[i].op == TAC_LABEL || ends_block(tac->code[i - 1].op))
+            count++;
+    }
+
+    cfg->blocks = (BasicBlock *)region_calloc(REGION_IR, count + 1, sizeof(BasicBlock));
+    cfg->block_of = (int *)region_alloc(REGION_IR, (tac->count + 1) * sizeof(int));
+    cfg->block_count = 0;
+    for (int i = 0; i < tac->count; i++)
+    {
+        if (i == 0 || tac->code[i].op == TAC_LABEL || ends_block(tac->code[i - 1].op))
+        {
+            BasicBlock *block = &cfg->blocks[cfg->block_count++];
+            block->first = i;
+            block->idom = -1;
+            block->rpo = -1;
+            block->loop = -1;
+        }
+        cfg->blocks[cfg->block_count - 1].last = i + 1;
+        cfg->block_of[i] = cfg->block_count - 1;
+    }
+}
+
+static void connect_blocks(Cfg *cfg)
+{
+    const TacBuffer *tac = cfg->tac;
+    int *label_block = (int *)region_alloc(REGION_IR, (tac->label_count + 1) * sizeof(int));
+    for (uint32_t i = 0; i < tac->label_count; i++)
+        label_block[i] = -1;
+    for (int i = 0; i < tac->count; i++)
+    {
+        if (tac->code[i].op == TAC_LABEL)
+            label_block[tac->code[i].result.id] = cfg->block_of[i];
+    }
+
+    int total = 0;
+    for (int b = 0; b < cfg->block_count; b++)
+    {
+        BasicBlock *block = &cfg->blocks[b];
+        const TAC *last = &tac->code[block->last - 1];
+        if (last->op == TAC_IF || last->op == TAC_GOTO)
+            block->succs[block->succ_count++] = label_block[last->result.id];
+        if (last->op != TAC_GOTO && b + 1 < cfg->block_count)
+            block->succs[block->succ_count++] = b + 1;
+        for (int s = 0; s < block->succ_count; s++)
+            cfg->blocks[block->succs[s]].pred_count++;
+        total += block->succ_count;
+    }
+
+    // Every predecessor list is a slice of one array
+    int *preds = (int *)region_alloc(REGION_IR, (total + 1) * sizeof(int));
+    for (int b = 0; b < cfg->block_count; b++)
+    {
+        cfg->blocks[b].preds = preds;
+        preds += cfg->blocks[b].pred_count;
+        cfg->blocks[b].pred_count = 0;
+    }
+    for (int b = 0; b < cfg->block_count; b++)
+    {
+        for (int s = 0; s < cfg->blocks[b].succ_count; s++)
+        {
+            BasicBlock *succ = &cfg->blocks[cfg->blocks[b].succs[s]];
+            succ->preds[succ->pred_count++] = b;
+        }
+    }
+}
+
+static void compute_order(Cfg *cfg)
+{
+    int *stack = (int *)region_alloc(REGION_IR, (cfg->block_count + 1) * sizeof(int));
+    int *next_succ = (int *)region_calloc(REGION_IR, cfg->block_count + 1, sizeof(int));
+    bool *visited = (bool *)region_calloc(REGION_IR, cfg->block_count + 1, sizeof(bool));
+    int *postorder = (int *)region_alloc(REGION_IR, (cfg->block_count + 1) * sizeof(int));
+    int top = 0;
+    int count = 0;
+
+    if (cfg->block_count > 0)
+    {
+        stack[top++] = 0;
+        visited[0] = true;
+    }
+    while (top > 0)
+    {
+        int b = stack[top - 1];
+        if (next_succ[b] < cfg->blocks[b].succ_count)
+        {
+            int succ = cfg->blocks[b].succs[next_succ[b]++];
+            if (!visited[succ])
+            {
+                visited[succ] = true;
+                stack[top++] = succ;
+            }
+            continue;
+        }
+        postorder[count++] = b;
+        top--;
+    }
+
+    cfg->order = (int *)region_alloc(REGION_IR, (count + 1) * sizeof(int));
+    cfg->order_count = count;
+    for (int i = 0; i < count; i++)
+    {
+        cfg->order[i] = postorder[count - 1 - i];
+        cfg->blocks[cfg->order[i]].rpo = i;
+    }
+}
+
+static int intersect(const Cfg *cfg, const int *idom, int a, int b)
+{
+    while (a != b)
+    {
+        while (cfg->blocks[a].rpo > cfg->blocks[b].rpo)
+            a = idom[a];
+        while (cfg->blocks[b].rpo > cfg->blocks[a].rpo)
+            b = idom[b];
+    }
+    return a;
+}
+
+// Cooper, Harvey and Kennedy's iterative algorithm over reverse postorder
+static void compute_dominators(Cfg *cfg)
+{
+    if (cfg->order_count == 0)
+        return;
+
+    int *idom = (int *)region_alloc(REGION_IR, (cfg->block_count + 1) * sizeof(int));
+    for (int b = 0; b < cfg->block_count; b++)
+        idom[b] = -1;
+    idom[0] = 0;
+
+    bool changed = true;
+    while (changed)
+    {
+        changed = false;
+        for (int i = 1; i < cfg->order_count; i++)
+        {
+            const BasicBlock *block = &cfg->blocks[cfg->order[i]];
+            int new_idom = -1;
+            for (int p = 0; p < block->pred_count; p++)
+            {
+                int pred = block->preds[p];
+                if (idom[pred] < 0)
+                    continue;
+                new_idom = new_idom < 0 ? pred : intersect(cfg, idom, pred, new_idom);
+            }
+            if (idom[cfg->order[i]] != new_idom)
+            {
+                idom[cfg->order[i]] = new_idom;
+                changed = true;
+            }
+        }
+    }
+
+    for (int b = 1; b < cfg->block_count; b++)
+        cfg->blocks[b].idom = idom[b];
+}
+
+bool cfg_dominates(const Cfg *cfg, int a, int b)
+{
+    if (cfg->blocks[b].rpo < 0)
+        return false;
+    while (b >= 0 && b != a)
+        b = cfg->blocks[b].idom;
+    return b == a;
+}
+
+static int compare_loop_size(const void *a, const void *b)
+{
+    return ((const Loop *)b)->block_count - ((const Loop *)a)->block_count;
+}
+
+static int compare_int(const void *a, const void *b)
+{
+    return *(const int *)a - *(const int *)b;
+}
+
+// An edge into a block that dominates its source closes a loop. The loop is
+// the header plus every block that reaches a latch without passing the header.
+static void find_loops(Cfg *cfg)
+{
+    int *stamp = (int *)region_calloc(REGION_IR, cfg->block_count + 1, sizeof(int));
+    int *body = (int *)region_alloc(REGION_IR, (cfg->block_count + 1) * sizeof(int));
+    int *latches = (int *)region_alloc(REGION_IR, (cfg->block_count + 1) * sizeof(int));
+
+    cfg->loops = (Loop *)region_alloc(REGION_IR, (cfg->block_count + 1) * sizeof(Loop));
+    cfg->loop_count = 0;
+
+    for (int h = 0; h < cfg->block_count; h++)
+    {
+        const BasicBlock *header = &cfg->blocks[h];
+        int latch_count = 0;
+        for (int p = 0; p < header->pred_count; p++)
+        {
+            if (cfg_dominates(cfg, h, header->preds[p]))
+                latches[latch_count++] = header->preds[p];
+        }
+        if (latch_count == 0)
+            continue;
+
+        int mark = cfg->loop_count + 1;
+        int count = 0;
+        stamp[h] = mark;
+        body[count++] = h;
+        int scan = count;
+        for (int l = 0; l < latch_count; l++)
+        {
+            if (stamp[latches[l]] != mark)
+            {
+                stamp[latches[l]] = mark;
+                body[count++] = latches[l];
+            }
+        }
+        while (scan < count)
+        {
+            const BasicBlock *block = &cfg->blocks[body[scan++]];
+            for (int p = 0; p < block->pred_count; p++)
+            {
+                int pred = block->preds[p];
+                if (stamp[pred] != mark && cfg->blocks[pred].rpo >= 0)
+                {
+                    stamp[pred] = mark;
+                    body[count++] = pred;
+                }
+            }
+        }
+
+        Loop *loop = &cfg->loops[cfg->loop_count++];
+        loop->header = h;
+        loop->block_count = count;
+        loop->blocks = (int *)region_alloc(REGION_IR, count * sizeof(int));
+        memcpy(loop->blocks, body, count * sizeof(int));
+        qsort(loop->blocks, count, sizeof(int), compare_int);
+        loop->latch_count = latch_count;
+        loop->latches = (int *)region_alloc(REGION_IR, latch_count * sizeof(int));
+        memcpy(loop->latches, latches, latch_count * sizeof(int));
+    }
+
+    // Larger loops first, so each loop's parent is already placed when its
+    // blocks claim their innermost loop
+    qsort(cfg->loops, cfg->loop_count, sizeof(Loop), compare_loop_size);
+    for (int l = 0; l < cfg->loop_count; l++)
+    {
+        Loop *loop = &cfg->loops[l];
+        loop->parent = cfg->blocks[loop->header].loop;
+        loop->depth = loop->parent < 0 ? 1 : cfg->loops[loop->parent].depth + 1;
+        for (int b = 0; b < loop->block_count; b++)
+            cfg->blocks[loop->blocks[b]].loop = l;
+    }
+}
+
+Cfg *build_cfg(const TacBuffer *tac)
+{
+    Cfg *cfg = (Cfg *)region_calloc(REGION_IR, 1, sizeof(Cfg));
+    cfg->tac = tac;
+    split_blocks(cfg);
+    connect_blocks(cfg);
+    compute_order(cfg);
+    compute_dominators(cfg);
+    find_loops(cfg);
+    return cfg;
+}
+
+bool cfg_loop_contains(const Cfg *cfg, int loop, int block)
+{
+    for (int l = cfg->blocks[block].loop; l >= 0; l = cfg->loops[l].parent)
+    {
+        if (l == loop)
+            return true;
+    }
+    return false;
+}
+
+int cfg_preheader(const Cfg *cfg, int loop)
+{
+    const BasicBlock *header = &cfg->blocks[cfg->loops[loop].header];
+    int entry = cfg->loops[loop].header - 1;
+    int entries = 0;
+
+    if (entry < 0)
+        return -1;
+    for (int p = 0; p < header->pred_count; p++)
+    {
+        if (!cfg_loop_contains(cfg, loop, header->preds[p]))
+        {
+            if (header->preds[p] != entry)
+                return -1;
+            entries++;
+        }
+    }
+    if (entries != 1)
+        return -1;
+
+    const TAC *last = &cfg->tac->code[cfg->blocks[entry].last - 1];
+    if (last->op == TAC_GOTO ||
+        (last->op == TAC_IF && last->result.id == cfg->tac->code[header->first].result.id))
+        return -1;
+    return entry;
+}
+
+// Graphviz labels need quotes and backslashes escaped; lines end with \l so
+// they are left aligned
+static void write_dot_text(FILE *out, const char *text)
+{
+    for (; *text; text++)
+    {
+        if (*text == '"' || *text == '\\')
+            fputc('\\', out);
+        fputc(*text, out);
+    }
+    fputs("\\l", out);
+}
+
+void write_cfg_dot(const Cfg *cfg, FILE *out)
+{
+    char text[TAC_TEXT_SIZE];
+    const SlotTable *slots = cfg->tac->slots;
+
+    fprintf(out, "digraph cfg {\n");
+    fprintf(out, "    node [shape=box, fontname=\"monospace\"];\n");
+    for (int b = 0; b < cfg->block_count; b++)
+    {
+        const BasicBlock *block = &cfg->blocks[b];
+        bool header = block->loop >= 0 && cfg->loops[block->loop].header == b;
+
+        fprintf(out, "    B%d [label=\"B%d", b, b);
+        if (header)
+            fprintf(out, " (loop header, depth %d)", cfg->loops[block->loop].depth);
+        if (block->idom >= 0)
+            fprintf(out, " idom B%d", block->idom);
+        fputs("\\l", out);
+        for (int i = block->first; i < block->last; i++)
+        {
+            format_tac(text, sizeof(text), &cfg->tac->code[i], slots);
+            write_dot_text(out, text);
+        }
+        fprintf(out, "\"");
+        if (block->rpo < 0)
+            fprintf(out, ", style=dashed");
+        else if (header)
+            fprintf(out, ", penwidth=2");
+        fprintf(out, "];\n");
+    }
+
+    for (int b = 0; b < cfg->block_count; b++)
+    {
+        const BasicBlock *block = &cfg->blocks[b];
+        bool branch = cfg->tac->code[block->last - 1].op == TAC_IF;
+        for (int s = 0; s < block->succ_count; s++)
+        {
+            int succ = block->succs[s];
+            fprintf(out, "    B%d -> B%d", b, succ);
+            if (branch)
+                fprintf(out, " [label=\"%s\"%s]", s == 0 ? "true" : "false",
+                        cfg_dominates(cfg, succ, b) ? ", style=dashed" : "");
+            else if (cfg_dominates(cfg, succ, b))
+                fprintf(out, " [style=dashed]");
+            fprintf(out, ";\n");
+        }
+    }
+    fprintf(out, "}\n");
+}
\ No newline at end of file
@@ -0,0 +1,588 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../include/regalloc.h"
+
+// Graph-coloring allocation with iterated coalescing (Chaitin, Briggs, George
+// and Appel). Nodes 0..REG_COUNT-1 stand for the machine registers; the others
+// are storage values. Two values interfere when one is written while the other
+// is live, and a call makes everything live across it interfere with the
+// registers it clobbers. Copies between values that do not interfere are
+// coalesced as long as the merged node stays colorable (Briggs' test), so
+// the `t = x` moves from expression lowering cost nothing. A node left
+// uncolored keeps its memory home; code generation reads it in place, so no
+// spill code has to be inserted and the graph is built only once.
+
+#define COLORS REG_COUNT
+
+typedef enum
+{
+    NODE_PRECOLORED,
+    NODE_UNUSED, // value never read or written
+    NODE_INITIAL,
+    NODE_SIMPLIFY,
+    NODE_FREEZE,
+    NODE_SPILL,
+    NODE_SPILLED,
+    NODE_COALESCED,
+    NODE_COLORED,
+    NODE_SELECTED
+} NodeState;
+
+typedef enum
+{
+    MOVE_WORKLIST,
+    MOVE_ACTIVE,
+    MOVE_COALESCED,
+    MOVE_CONSTRAINED,
+    MOVE_FROZEN
+} MoveState;
+
+typedef struct
+{
+    int node;
+    int next;
+} Link;
+
+typedef struct
+{
+    int dst;
+    int src;
+    MoveState state;
+} Move;
+
+typedef struct
+{
+    int node_count;
+    NodeState *state;
+    int *degree;
+    int *alias;
+    int *color;
+    int64_t *weight;
+    int *adjacent;  // head of each node's Link chain of neighbours
+    int *moves;     // head of each node's Link chain of move indexes
+    Link *links;
+    int link_count;
+    int link_capacity;
+
+    // Edge set, open addressing on (low, high) node pairs
+    uint64_t *edges;
+    uint32_t edge_mask;
+    int edge_count;
+
+    // simplify, freeze and spill worklists, doubly linked through prev/next
+    int heads[3];
+    int *prev;
+    int *next;
+
+    Move *move_list;
+    int move_count;
+    int move_capacity;
+    int *move_work; // worklist moves, popped lazily by state
+    int move_top;
+
+    int *select;
+    int select_top;
+    int *mark;
+    int stamp;
+} Graph;
+
+static bool is_precolored(int node)
+{
+    return node < COLORS;
+}
+
+static int worklist_of(NodeState state)
+{
+    return state == NODE_SIMPLIFY ? 0 : state == NODE_FREEZE ? 1 : state == NODE_SPILL ? 2 : -1;
+}
+
+static void set_state(Graph *graph, int node, NodeState state)
+{
+    int old = worklist_of(graph->state[node]);
+    if (old >= 0)
+    {
+        if (graph->prev[node] >= 0)
+            graph->next[graph->prev[node]] = graph->next[node];
+        else
+            graph->heads[old] = graph->next[node];
+        if (graph->next[node] >= 0)
+            graph->prev[graph->next[node]] = graph->prev[node];
+    }
+    graph->state[node] = state;
+    int list = worklist_of(state);
+    if (list >= 0)
+    {
+        graph->prev[node] = -1;
+        graph->next[node] = graph->heads[list];
+        if (graph->heads[list] >= 0)
+            graph->prev[graph->heads[list]] = node;
+        graph->heads[list] = node;
+    }
+}
+
+static void link(Graph *graph, int *head, int node)
+{
+    if (graph->link_count >= graph->link_capacity)
+    {
+        int grown = graph->link_capacity * 2;
+        graph->links = (Link *)region_grow(REGION_IR, graph->links, graph->link_capacity * sizeof(Link),
+                                           grown * sizeof(Link));
+        graph->link_capacity = grown;
+    }
+    graph->links[graph->link_count].node = node;
+    graph->links[graph->link_count].next = *head;
+    *head = graph->link_count++;
+}
+
+static uint64_t edge_key(int u, int v)
+{
+    return u < v ? ((uint64_t)u << 32 | (uint32_t)v) + 1 : ((uint64_t)v << 32 | (uint32_t)u) + 1;
+}
+
+static uint32_t edge_slot(const Graph *graph, uint64_t key)
+{
+    uint32_t slot = (uint32_t)((key * 0x9e3779b97f4a7c15ull) >> 32) & graph->edge_mask;
+    while (graph->edges[slot] != 0 && graph->edges[slot] != key)
+        slot = (slot + 1) & graph->edge_mask;
+    return slot;
+}
+
+static bool interferes(const Graph *graph, int u, int v)
+{
+    return graph->edges[edge_slot(graph, edge_key(u, v))] != 0;
+}
+
+static void add_edge(Graph *graph, int u, int v)
+{
+    if (u == v || (is_precolored(u) && is_precolored(v)))
+        return;
+    uint64_t key = edge_key(u, v);
+    uint32_t slot = edge_slot(graph, key);
+    if (graph->edges[slot] != 0)
+        return;
+    graph->edges[slot] = key;
+
+    if (++graph->edge_count * 2 > (int)graph->edge_mask)
+    {
+        uint64_t *old = graph->edges;
+        uint32_t old_size = graph->edge_mask + 1;
+        graph->edge_mask = old_size * 2 - 1;
+        graph->edges = (uint64_t *)region_calloc(REGION_IR, old_size * 2, sizeof(uint64_t));
+        for (uint32_t i = 0; i < old_size; i++)
+        {
+            if (old[i] != 0)
+                graph->edges[edge_slot(graph, old[i])] = old[i];
+        }
+    }
+
+    if (!is_precolored(u))
+    {
+        link(graph, &graph->adjacent[u], v);
+        graph->degree[u]++;
+    }
+    if (!is_precolored(v))
+    {
+        link(graph, &graph->adjacent[v], u);
+        graph->degree[v]++;
+    }
+}
+
+static void add_move(Graph *graph, int dst, int src)
+{
+    if (graph->move_count >= graph->move_capacity)
+    {
+        int grown = graph->move_capacity * 2;
+        graph->move_list = (Move *)region_grow(REGION_IR, graph->move_list, graph->move_capacity * sizeof(Move),
+                                               grown * sizeof(Move));
+        graph->move_work = (int *)region_grow(REGION_IR, graph->move_work, graph->move_capacity * sizeof(int),
+                                              grown * sizeof(int));
+        graph->move_capacity = grown;
+    }
+    int m = graph->move_count++;
+    graph->move_list[m].dst = dst;
+    graph->move_list[m].src = src;
+    graph->move_list[m].state = MOVE_WORKLIST;
+    graph->move_work[graph->move_top++] = m;
+    link(graph, &graph->moves[dst], m);
+    link(graph, &graph->moves[src], m);
+}
+
+static bool is_removed(const Graph *graph, int node)
+{
+    return graph->state[node] == NODE_SELECTED || graph->state[node] == NODE_COALESCED;
+}
+
+static bool is_pending(const Graph *graph, int move)
+{
+    return graph->move_list[move].state == MOVE_WORKLIST || graph->move_list[move].state == MOVE_ACTIVE;
+}
+
+static bool move_related(const Graph *graph, int node)
+{
+    for (int l = graph->moves[node]; l >= 0; l = graph->links[l].next)
+    {
+        if (is_pending(graph, graph->links[l].node))
+            return true;
+    }
+    return false;
+}
+
+static int get_alias(const Graph *graph, int node)
+{
+    while (graph->state[node] == NODE_COALESCED)
+        node = graph->alias[node];
+    return node;
+}
+
+static void enable_moves(Graph *graph, int node)
+{
+    for (int l = graph->moves[node]; l >= 0; l = graph->links[l].next)
+    {
+        int m = graph->links[l].node;
+        if (graph->move_list[m].state == MOVE_ACTIVE)
+        {
+            graph->move_list[m].state = MOVE_WORKLIST;
+            graph->move_work[graph->move_top++] = m;
+        }
+    }
+}
+
+static void decrement_degree(Graph *graph, int node)
+{
+    if (is_precolored(node))
+        return;
+    if (graph->degree[node]-- != COLORS)
+        return;
+
+    // The node just became colorable, and so may moves next to it
+    enable_moves(graph, node);
+    for (int l = graph->adjacent[node]; l >= 0; l = graph->links[l].next)
+    {
+        if (!is_removed(graph, graph->links[l].node))
+            enable_moves(graph, graph->links[l].node);
+    }
+    if (graph->state[node] == NODE_SPILL)
+        set_state(graph, node, move_related(graph, node) ? NODE_FREEZE : NODE_SIMPLIFY);
+}
+
+static void simplify(Graph *graph)
+{
+    int node = graph->heads[0];
+    set_state(graph, node, NODE_SELECTED);
+    graph->select[graph->select_top++] = node;
+    for (int l = graph->adjacent[node]; l >= 0; l = graph->links[l].next)
+    {
+        if (!is_removed(graph, graph->links[l].node))
+            decrement_degree(graph, graph->links[l].node);
+    }
+}
+
+static void add_worklist(Graph *graph, int node)
+{
+    if (!is_precolored(node) && graph->state[node] == NODE_FREEZE && !move_related(graph, node) &&
+        graph->degree[node] < COLORS)
+        set_state(graph, node, NODE_SIMPLIFY);
+}
+
+// Briggs: the merged node has fewer than COLORS neighbours of significant degree
+static bool conservative(Graph *graph, int u, int v)
+{
+    graph->stamp++;
+    int significant = 0;
+    const int nodes[] = {u, v};
+    for (int i = 0; i < 2; i++)
+    {
+        for (int l = graph->adjacent[nodes[i]]; l >= 0; l = graph->links[l].next)
+        {
+            int t = graph->links[l].node;
+            if (is_removed(graph, t) || graph->mark[t] == graph->stamp)
+                continue;
+            graph->mark[t] = graph->stamp;
+            if (is_precolored(t) || graph->degree[t] >= COLORS)
+                significant++;
+        }
+    }
+    return significant < COLORS;
+}
+
+static void combine(Graph *graph, int u, int v)
+{
+    set_state(graph, v, NODE_COALESCED);
+    graph->alias[v] = u;
+    graph->weight[u] += graph->weight[v];
+    for (int l = graph->moves[v]; l >= 0; l = graph->links[l].next)
+        link(graph, &graph->moves[u], graph->links[l].node);
+    enable_moves(graph, v);
+    for (int l = graph->adjacent[v]; l >= 0; l = graph->links[l].next)
+    {
+        int t = graph->links[l].node;
+        if (is_removed(graph, t))
+            continue;
+        add_edge(graph, t, u);
+        decrement_degree(graph, t);
+    }
+    if (graph->degree[u] >= COLORS && graph->state[u] == NODE_FREEZE)
+        set_state(graph, u, NODE_SPILL);
+}
+
+static void coalesce(Graph *graph, int m, RegisterAllocation *allocation)
+{
+    int u = get_alias(graph, graph->move_list[m].dst);
+    int v = get_alias(graph, graph->move_list[m].src);
+    if (u == v)
+    {
+        graph->move_list[m].state = MOVE_COALESCED;
+        add_worklist(graph, u);
+    }
+    else if (interferes(graph, u, v))
+    {
+        graph->move_list[m].state = MOVE_CONSTRAINED;
+        add_worklist(graph, u);
+        add_worklist(graph, v);
+    }
+    else if (conservative(graph, u, v))
+    {
+        graph->move_list[m].state = MOVE_COALESCED;
+        allocation->coalesced++;
+        combine(graph, u, v);
+        add_worklist(graph, u);
+    }
+    else
+    {
+        graph->move_list[m].state = MOVE_ACTIVE;
+    }
+}
+
+// Gives up on coalescing node's moves so it can be simplified
+static void freeze_moves(Graph *graph, int node)
+{
+    for (int l = graph->moves[node]; l >= 0; l = graph->links[l].next)
+    {
+        int m = graph->links[l].node;
+        if (!is_pending(graph, m))
+            continue;
+        int other = get_alias(graph, graph->move_list[m].src);
+        if (other == get_alias(graph, node))
+            other = get_alias(graph, graph->move_list[m].dst);
+        graph->move_list[m].state = MOVE_FROZEN;
+        if (graph->state[other] == NODE_FREEZE && !move_related(graph, other) && graph->degree[other] < COLORS)
+            set_state(graph, other, NODE_SIMPLIFY);
+    }
+}
+
+static void freeze(Graph *graph)
+{
+    int node = graph->heads[1];
+    set_state(graph, node, NODE_SIMPLIFY);
+    freeze_moves(graph, node);
+}
+
+// Chaitin's choice: the node whose spilling costs least per neighbour freed
+static void select_spill(Graph *graph)
+{
+    int best = graph->heads[2];
+    for (int n = graph->next[best]; n >= 0; n = graph->next[n])
+    {
+        if (graph->weight[n] * graph->degree[best] < graph->weight[best] * graph->degree[n])
+            best = n;
+    }
+    set_state(graph, best, NODE_SIMPLIFY);
+    freeze_moves(graph, best);
+}
+
+static void assign_colors(Graph *graph, RegisterAllocation *allocation)
+{
+    while (graph->select_top > 0)
+    {
+        int node = graph->select[--graph->select_top];
+        bool taken[COLORS] = {false};
+        for (int l = graph->adjacent[node]; l >= 0; l = graph->links[l].next)
+        {
+            int t = get_alias(graph, graph->links[l].node);
+            if (graph->state[t] == NODE_COLORED || is_precolored(t))
+                taken[graph->color[t]] = true;
+        }
+
+        // Registers that calls clobber first, as in linear scan, keeping the
+        // preserved ones for values that live across calls
+        int color = REG_NONE;
+        for (int r = 0; r < COLORS && color == REG_NONE; r++)
+        {
+            if (!taken[r])
+                color = r;
+        }
+        if (color == REG_NONE)
+        {
+            set_state(graph, node, NODE_SPILLED);
+            continue;
+        }
+        set_state(graph, node, NODE_COLORED);
+        graph->color[node] = color;
+    }
+
+    for (int n = COLORS; n < graph->node_count; n++)
+    {
+        int value = n - COLORS;
+        int root = get_alias(graph, n);
+        if (graph->state[root] == NODE_COLORED)
+        {
+            allocation->location[value] = graph->color[root];
+            allocation->allocated++;
+        }
+        else if (graph->state[root] == NODE_SPILLED)
+        {
+            allocation->spilled++;
+        }
+    }
+}
+
+static void build(Graph *graph, const Liveness *liveness)
+{
+    const Cfg *cfg = liveness->cfg;
+    const TacBuffer *tac = cfg->tac;
+    uint64_t *live = (uint64_t *)region_alloc(REGION_IR, (liveness->words + 1) * sizeof(uint64_t));
+
+    for (int b = 0; b < cfg->block_count; b++)
+    {
+        const BasicBlock *block = &cfg->blocks[b];
+        int64_t weight = block_weight(cfg, b);
+        memcpy(live, &liveness->live_out[b * liveness->words], liveness->words * sizeof(uint64_t));
+
+        for (int i = block->last - 1; i >= block->first; i--)
+        {
+            const TAC *code = &tac->code[i];
+            int def = liveness_value(tac, code->result);
+            int uses[] = {liveness_value(tac, code->arg1), liveness_value(tac, code->arg2)};
+
+            if (def >= 0)
+            {
+                liveness_remove(live, def);
+                graph->weight[COLORS + def] += weight;
+                graph->state[COLORS + def] = NODE_INITIAL;
+            }
+            if (code->op == TAC_ASSIGN && def >= 0 && uses[0] >= 0 && def != uses[0])
+            {
+                liveness_remove(live, uses[0]);
+                add_move(graph, COLORS + def, COLORS + uses[0]);
+            }
+
+            for (int w = 0; w < liveness->words; w++)
+            {
+                for (uint64_t bits = live[w]; bits != 0; bits &= bits - 1)
+                {
+                    int value = w * 64 + __builtin_ctzll(bits);
+                    if (def >= 0)
+                        add_edge(graph, COLORS + def, COLORS + value);
+                    if (code->op == TAC_CALL)
+                    {
+                        for (int r = 0; r < COLORS; r++)
+                        {
+                            if (!machine_registers[r].preserved)
+                                add_edge(graph, r, COLORS + value);
+                        }
+                    }
+                }
+            }
+
+            for (int u = 0; u < 2; u++)
+            {
+                if (uses[u] < 0)
+                    continue;
+                liveness_add(live, uses[u]);
+                graph->weight[COLORS + uses[u]] += weight;
+                graph->state[COLORS + uses[u]] = NODE_INITIAL;
+            }
+        }
+    }
+
+    // Values live on entry are loaded together before the first instruction
+    const uint64_t *entry = liveness->live_in;
+    for (int u = 0; u < liveness->value_count; u++)
+    {
+        for (int v = u + 1; liveness_contains(entry, u) && v < liveness->value_count; v++)
+        {
+            if (liveness_contains(entry, v))
+                add_edge(graph, COLORS + u, COLORS + v);
+        }
+    }
+}
+
+static Graph *create_graph(int value_count, int instruction_count)
+{
+    Graph *graph = (Graph *)region_calloc(REGION_IR, 1, sizeof(Graph));
+    int n = COLORS + value_count;
+    graph->node_count = n;
+    graph->state = (NodeState *)region_alloc(REGION_IR, n * sizeof(NodeState));
+    graph->degree = (int *)region_calloc(REGION_IR, n, sizeof(int));
+    graph->alias = (int *)region_alloc(REGION_IR, n * sizeof(int));
+    graph->color = (int *)region_alloc(REGION_IR, n * sizeof(int));
+    graph->weight = (int64_t *)region_calloc(REGION_IR, n, sizeof(int64_t));
+    graph->adjacent = (int *)region_alloc(REGION_IR, n * sizeof(int));
+    graph->moves = (int *)region_alloc(REGION_IR, n * sizeof(int));
+    graph->prev = (int *)region_alloc(REGION_IR, n * sizeof(int));
+    graph->next = (int *)region_alloc(REGION_IR, n * sizeof(int));
+    graph->select = (int *)region_alloc(REGION_IR, n * sizeof(int));
+    graph->mark = (int *)region_calloc(REGION_IR, n, sizeof(int));
+    for (int i = 0; i < n; i++)
+    {
+        graph->state[i] = i < COLORS ? NODE_PRECOLORED : NODE_UNUSED;
+        graph->color[i] = i < COLORS ? i : REG_NONE;
+        graph->adjacent[i] = -1;
+        graph->moves[i] = -1;
+    }
+    for (int i = 0; i < 3; i++)
+        graph->heads[i] = -1;
+
+    graph->link_capacity = instruction_count * 4 + 64;
+    graph->links = (Link *)region_alloc(REGION_IR, graph->link_capacity * sizeof(Link));
+    graph->edge_mask = 1023;
+    graph->edges = (uint64_t *)region_calloc(REGION_IR, graph->edge_mask + 1, sizeof(uint64_t));
+    graph->move_capacity = 64;
+    graph->move_list = (Move *)region_alloc(REGION_IR, graph->move_capacity * sizeof(Move));
+    graph->move_work = (int *)region_alloc(REGION_IR, graph->move_capacity * sizeof(int));
+    return graph;
+}
+
+RegisterAllocation *allocate_graph_coloring(const TacBuffer *tac)
+{
+    Cfg *cfg = build_cfg(tac);
+    Liveness *liveness = compute_liveness(cfg);
+    RegisterAllocation *allocation = create_allocation(liveness->value_count);
+    Graph *graph = create_graph(liveness->value_count, tac->count);
+    build(graph, liveness);
+
+    for (int n = COLORS; n < graph->node_count; n++)
+    {
+        if (graph->state[n] != NODE_INITIAL)
+            continue;
+        if (graph->degree[n] >= COLORS)
+            set_state(graph, n, NODE_SPILL);
+        else if (move_related(graph, n))
+            set_state(graph, n, NODE_FREEZE);
+        else
+            set_state(graph, n, NODE_SIMPLIFY);
+    }
+
+    while (true)
+    {
+        if (graph->heads[0] >= 0)
+            simplify(graph);
+        else if (graph->move_top > 0)
+        {
+            int m = graph->move_work[--graph->move_top];
+            if (graph->move_list[m].state == MOVE_WORKLIST)
+                coalesce(graph, m, allocation);
+        }
+        else if (graph->heads[1] >= 0)
+            freeze(graph);
+        else if (graph->heads[2] >= 0)
+            select_spill(graph);
+        else
+            break;
+    }
+
+    assign_colors(graph, allocation);
+    assign_frame_slots(liveness, allocation);
+    return allocation;
+}
\ No newline at end of file
@@ -2,72 +2,24 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdarg.h>
-#include <ctype.h>
+#include <stdint.h>
 #include "../include/gen.h"
 
 #define INITIAL_OUTPUT_SIZE 1024
-#define MAX_REGISTERS 8
 
 GenContext *create_gen_context(void)
 {
-    GenContext *context = (GenContext *)malloc(sizeof(GenContext));
-    if (!context)
-    {
-        fprintf(stderr, "Error: Memory allocation failed for GenContext\n");
-        exit(1);
-    }
-
-    context->reg_count = MAX_REGISTERS;
-    context->registers = (Register *)malloc(sizeof(Register) * MAX_REGISTERS);
-    if (!context->registers)
-    {
-        fprintf(stderr, "Error: Memory allocation failed for registers\n");
-        free(context);
-        exit(1);
-    }
-
-    const char *reg_names[] = {"rax", "rbx", "rcx", "rdx", "rsi", "r8", "r9"};
-    for (int i = 0; i < MAX_REGISTERS; i++)
-    {
-        context->registers[i].name = strdup(reg_names[i]);
-        context->registers[i].variable = NULL;
-        context->registers[i].is_free = 1; 
-    }
+    GenContext *context = (GenContext *)region_alloc(REGION_OUTPUT, sizeof(GenContext));
 
+    context->allocation = NULL;
     context->output_size = INITIAL_OUTPUT_SIZE;
-    context->output = (char *)malloc(context->output_size);
-    if (!context->output)
-    {
-        fprintf(stderr, "Error: Memory allocation failed for output buffer\n");
-        for (int i = 0; i < MAX_REGISTERS; i++)
-            free(context->registers[i].name);
-        free(context->registers);
-        free(context);
-        exit(1);
-    }
+    context->output = (char *)region_alloc(REGION_OUTPUT, context->output_size);
     context->output[0] = '\0';
     context->output_pos = 0;
-    context->current_reg = 0;
 
     return context;
 }
 
-void free_gen_context(GenContext *context)
-{
-    if (!context)
-        return;
-
-    for (int i = 0; i < context->reg_count; i++)
-    {
-        free(context->registers[i].name);
-        if (context->registers[i].variable)
-            free(context->registers[i].variable);
-    }
-    free(context->registers);
-    free(context->output);
-    free(context);
-}
-
 void append_code(GenContext *context, const char *format, ...)
 {
     va_list args;
@@ -84,13 +36,8 @@ void append_code(GenContext *context, const char *format, ...)
         while (new_size < context->output_pos + required_size + 1)
             new_size *= 2;
 
-        char *new_output = realloc(context->output, new_size);
-        if (!new_output)
-        {
-            fprintf(stderr, "Error: Memory reallocation failed for output buffer\n");
-            exit(1);
-        }
-        context->output = new_output;
+        // The output buffer is usually the newest allocation, so this extends in place
+        context->output = (char *)region_grow(REGION_OUTPUT, context->output, context->output_size, new_size);
         context->output_size = new_size;
     }
 
@@ -103,309 +50,415 @@ void append_code(GenContext *context, const char *format, ...)
     va_end(args);
 }
 
-Register *allocate_register(GenContext *context, const char *variable)
+// Compiler-made symbols contain a '.', which no identifier can, so they never
+// clash with the program's own variables
+#define SYMBOL_SIZE 32
+
+// Assembly symbol of a label, or of a temp or variable placed in .bss
+static const char *symbol_name(const TacBuffer *tac, Operand operand, char *buffer)
+{
+    switch (operand.kind)
+    {
+    case OPERAND_VAR:
+        return name_str(tac->slots->slots[operand.id].label);
+    case OPERAND_TEMP:
+        snprintf(buffer, SYMBOL_SIZE, "t.%u", operand.id);
+        return buffer;
+    case OPERAND_LABEL:
+        snprintf(buffer, SYMBOL_SIZE, "L.%u", operand.id);
+        return buffer;
+    default:
+        buffer[0] = '\0';
+        return buffer;
+    }
+}
+
+// Register the allocator gave a temp or variable, or NULL when it lives in memory
+static const char *register_of(const GenContext *context, const TacBuffer *tac, Operand operand)
+{
+    int value = liveness_value(tac, operand);
+    if (value < 0 || context->allocation->location[value] == REG_NONE)
+        return NULL;
+    return machine_registers[context->allocation->location[value]].name;
+}
+
+// Memory operand of a temp or variable kept in memory, or NULL
+static const char *memory_of(const GenContext *context, const TacBuffer *tac, Operand operand)
+{
+    int value = liveness_value(tac, operand);
+    return value < 0 ? NULL : context->addresses[value];
+}
+
+// Load any value operand into a register
+static void load_operand(GenContext *context, const TacBuffer *tac, const char *reg, Operand operand)
+{
+    const char *from = register_of(context, tac, operand);
+    if (from != NULL)
+    {
+        if (strcmp(from, reg) != 0)
+            append_code(context, "    mov %s, %s\n", reg, from);
+    }
+    else if (operand.kind == OPERAND_IMM)
+        append_code(context, "    mov %s, %lld\n", reg, (long long)operand.imm);
+    else if (operand.kind == OPERAND_STRING)
+        append_code(context, "    lea %s, [rel string.%u]\n", reg, operand.id);
+    else
+        append_code(context, "    mov %s, %s\n", reg, memory_of(context, tac, operand));
+}
+
+// Source operand of a two-operand instruction: a register, memory, a 32-bit
+// immediate, or else the value loaded into rcx
+static const char *source_operand(GenContext *context, const TacBuffer *tac, Operand operand, char *buffer)
 {
-    for (int i = 0; i < context->reg_count; i++)
+    const char *reg = register_of(context, tac, operand);
+    if (reg != NULL)
+        return reg;
+    if (memory_of(context, tac, operand) != NULL)
+        return memory_of(context, tac, operand);
+    if (operand.kind == OPERAND_IMM && operand.imm >= INT32_MIN && operand.imm <= INT32_MAX)
     {
-        if (context->registers[i].is_free)
+        snprintf(buffer, SYMBOL_SIZE * 2, "%lld", (long long)operand.imm);
+        return buffer;
+    }
+    load_operand(context, tac, "rcx", operand);
+    return "rcx";
+}
+
+// Register an instruction computes its result in: the result's own register
+// when it has one, else rax
+static const char *result_register(const GenContext *context, const TacBuffer *tac, Operand result)
+{
+    const char *reg = register_of(context, tac, result);
+    return reg != NULL ? reg : "rax";
+}
+
+static void store_result(GenContext *context, const TacBuffer *tac, Operand result, const char *reg)
+{
+    const char *target = register_of(context, tac, result);
+    if (target == NULL)
+        append_code(context, "    mov %s, %s\n", memory_of(context, tac, result), reg);
+    else if (strcmp(target, reg) != 0)
+        append_code(context, "    mov %s, %s\n", target, reg);
+}
+
+static bool same_register(const char *reg, const char *other)
+{
+    return reg != NULL && other != NULL && strcmp(reg, other) == 0;
+}
+
+static void emit_arithmetic(GenContext *context, const TacBuffer *tac, const TAC *current, const char *mnemonic)
+{
+    char source[SYMBOL_SIZE * 2];
+    const char *target = result_register(context, tac, current->result);
+    Operand left = current->arg1;
+    Operand right = current->arg2;
+
+    // Loading the left operand into the target must not overwrite the right one
+    if (same_register(target, register_of(context, tac, right)) &&
+        !same_register(target, register_of(context, tac, left)))
+    {
+        if (current->op == TAC_ADD || current->op == TAC_MUL)
         {
-            context->registers[i].is_free = 0;
-            if (context->registers[i].variable)
-                free(context->registers[i].variable);
-            context->registers[i].variable = strdup(variable);
-            return &context->registers[i];
+            left = current->arg2;
+            right = current->arg1;
         }
+        else
+            target = "rax";
     }
-    Register *reg = &context->registers[context->current_reg];
-    context->current_reg = (context->current_reg + 1) % context->reg_count;
-    if (reg->variable)
-        free(reg->variable);
-    reg->variable = strdup(variable);
-    return reg;
+
+    load_operand(context, tac, target, left);
+    append_code(context, "    %s %s, %s\n", mnemonic, target, source_operand(context, tac, right, source));
+    store_result(context, tac, current->result, target);
 }
 
-void free_register(GenContext *context, Register *reg)
+// Condition code under which a comparison holds, or fails
+static const char *condition_code(TACOpType op, bool negate)
 {
-    if (!reg)
-        return;
-    reg->is_free = 1;
-    if (reg->variable)
+    switch (op)
     {
-        free(reg->variable);
-        reg->variable = NULL;
+    case TAC_LESS:
+        return negate ? "ge" : "l";
+    case TAC_LESS_EQ:
+        return negate ? "g" : "le";
+    case TAC_GREATER:
+        return negate ? "le" : "g";
+    case TAC_GREATER_EQ:
+        return negate ? "l" : "ge";
+    case TAC_EQ:
+        return negate ? "ne" : "e";
+    default:
+        return negate ? "e" : "ne";
     }
 }
 
-// Helper function to check if a string is a label (starts with 'L' followed by digits)
-static int is_label(const char *str)
+// Sets the flags for the comparison, and materializes its 0/1 result only when
+// something still reads it; setcc, movzx and mov leave the flags alone
+static void emit_compare(GenContext *context, const TacBuffer *tac, const TAC *current, bool keep_result)
 {
-    if (!str || strlen(str) == 0)
-        return 0;
-    if (str[0] != 'L')
-        return 0;
-    for (int i = 1; i < strlen(str); i++)
+    char source[SYMBOL_SIZE * 2];
+    const char *left = register_of(context, tac, current->arg1);
+    if (left == NULL)
     {
-        if (!isdigit(str[i]))
-            return 0;
+        load_operand(context, tac, "rax", current->arg1);
+        left = "rax";
     }
-    return 1;
+    append_code(context, "    cmp %s, %s\n", left, source_operand(context, tac, current->arg2, source));
+    if (!keep_result)
+        return;
+    const char *target = result_register(context, tac, current->result);
+    append_code(context, "    set%s al\n", condition_code(current->op, false));
+    append_code(context, "    movzx %s, al\n", target);
+    store_result(context, tac, current->result, target);
 }
 
-char *generate_code(TAC *tac)
+// Whether a label starts the run of labels right after code[i]
+static bool label_follows(const TacBuffer *tac, int i, Operand label)
 {
-    GenContext *context = create_gen_context();
-    char declared[256][64] = {{0}};
-    int declared_count = 0;
-    int string_count = 0;              
-    char string_vars[256][64] = {{0}}; 
-    int string_var_count = 0;
-
-    TAC *current = tac;
-    while (current)
+    for (int j = i + 1; j < tac->count && tac->code[j].op == TAC_LABEL; j++)
+    {
+        if (tac->code[j].result.id == label.id)
+            return true;
+    }
+    return false;
+}
+
+// Conditional jump for the IF at code[i]. An IF followed by `goto else; then:`
+// becomes a single jump to else on the inverse condition that falls through
+// into then. Returns the last instruction it covers.
+static int emit_branch(GenContext *context, const TacBuffer *tac, int i, TACOpType op)
+{
+    char symbol[SYMBOL_SIZE];
+    if (i + 1 < tac->count && tac->code[i + 1].op == TAC_GOTO &&
+        label_follows(tac, i + 1, tac->code[i].result))
     {
-#define ADD_VAR_IF_NOT_DECLARED(var)                                                                                \
-    do                                                                                                              \
-    {                                                                                                               \
-        if ((var) && strlen(var) > 0 && (var)[0] != '"' && !isdigit((var)[0]) && (var)[0] != '-' && !is_label(var)) \
-        {                                                                                                           \
-            int found = 0;                                                                                          \
-            for (int i = 0; i < declared_count; i++)                                                                \
-            {                                                                                                       \
-                if (strcmp(declared[i], (var)) == 0)                                                                \
-                {                                                                                                   \
-                    found = 1;                                                                                      \
-                    break;                                                                                          \
-                }                                                                                                   \
-            }                                                                                                       \
-            if (!found)                                                                                             \
-                strcpy(declared[declared_count++], (var));                                                          \
-        }                                                                                                           \
-    } while (0)
-
-        ADD_VAR_IF_NOT_DECLARED(current->result);
-        ADD_VAR_IF_NOT_DECLARED(current->arg1);
-        ADD_VAR_IF_NOT_DECLARED(current->arg2);
-
-#undef ADD_VAR_IF_NOT_DECLARED
-
-        current = current->next;
+        if (!label_follows(tac, i + 1, tac->code[i + 1].result))
+            append_code(context, "    j%s %s\n", condition_code(op, true),
+                        symbol_name(tac, tac->code[i + 1].result, symbol));
+        return i + 1;
     }
+    append_code(context, "    j%s %s\n", condition_code(op, false), symbol_name(tac, tac->code[i].result, symbol));
+    return i;
+}
+
+// Temp or variable a liveness value stands for
+static Operand value_operand(const TacBuffer *tac, int value)
+{
+    if (value < (int)tac->temp_count)
+        return make_operand(OPERAND_TEMP, (uint32_t)value);
+    return make_operand(OPERAND_VAR, (uint32_t)(value - tac->temp_count));
+}
 
-    append_code(context, "section .data\n");
-    for (int i = 0; i < declared_count; i++)
+// Memory operands of the values the allocation keeps in memory: an rbp-relative
+// frame slot, or the value's own .bss cell once the frame is full
+static void place_values(GenContext *context, const TacBuffer *tac)
+{
+    const RegisterAllocation *allocation = context->allocation;
+    char symbol[SYMBOL_SIZE];
+    context->addresses = (const char **)region_calloc(REGION_OUTPUT, allocation->value_count + 1, sizeof(char *));
+    for (int v = 0; v < allocation->value_count; v++)
     {
-        if (strcmp(declared[i], "show") == 0)
+        if (allocation->slot[v] == FRAME_SLOT_NONE)
             continue;
-        append_code(context, "    %s: dq 0\n", declared[i]);
+        const char *name = symbol_name(tac, value_operand(tac, v), symbol);
+        size_t size = strlen(name) + SYMBOL_SIZE;
+        char *address = (char *)region_alloc(REGION_OUTPUT, size);
+        if (allocation->slot[v] == FRAME_SLOT_GLOBAL)
+            snprintf(address, size, "[%s]", name);
+        else
+            snprintf(address, size, "[rbp - %d]", (allocation->slot[v] + 1) * 8);
+        context->addresses[v] = address;
     }
+}
 
-    current = tac;
-    while (current)
+// Storage comes from the allocation: registers, slots of a frame shared by
+// values that are never live at once, and .bss for what does not fit in it.
+// String literals are the only initialized data.
+char *generate_code(const TacBuffer *tac, const RegisterAllocation *allocation)
+{
+    GenContext *context = create_gen_context();
+    context->allocation = allocation;
+    place_values(context, tac);
+    char symbol[SYMBOL_SIZE];
+
+    // One copy of each distinct string literal, named by its interned text
+    bool *declared = (bool *)region_calloc(REGION_OUTPUT, name_count(), sizeof(bool));
+    bool any_string = false;
+    for (int i = 0; i < tac->count; i++)
     {
-        if (current->op == TAC_ASSIGN && current->arg1 && current->arg1[0] == '"')
+        const Operand operands[] = {tac->code[i].arg1, tac->code[i].arg2};
+        for (int j = 0; j < 2; j++)
         {
-            char string_content[256];
-            strncpy(string_content, current->arg1 + 1, strlen(current->arg1) - 2); 
-            string_content[strlen(current->arg1) - 2] = '\0';
+            if (operands[j].kind == OPERAND_STRING && !declared[operands[j].id])
+            {
+                if (!any_string)
+                    append_code(context, "section .data\n");
+                any_string = true;
+                append_code(context, "    string.%u: db \"%s\", 0\n", operands[j].id, name_str(operands[j].id));
+                declared[operands[j].id] = true;
+            }
+        }
+    }
 
-            append_code(context, "    string_%d: db \"%s\", 0\n", string_count, string_content);
-            string_count++;
+    if (allocation->globals > 0)
+    {
+        append_code(context, "%ssection .bss\n", any_string ? "\n" : "");
+        for (int v = 0; v < allocation->value_count; v++)
+        {
+            if (allocation->slot[v] == FRAME_SLOT_GLOBAL)
+                append_code(context, "    %s: resq 1\n", symbol_name(tac, value_operand(tac, v), symbol));
         }
-        current = current->next;
     }
 
-    append_code(context, "\nsection .text\n");
+    append_code(context, "%ssection .text\n", any_string || allocation->globals > 0 ? "\n" : "");
     append_code(context, "global _start\n");
     append_code(context, "extern show_num\n");
     append_code(context, "extern show_str\n");
     append_code(context, "extern process_exit\n\n");
     append_code(context, "_start:\n");
 
-    current = tac;
-    string_count = 0; 
-    while (current)
+    // The frame holds the slots and the 32 bytes of shadow space every win64
+    // call needs above the stack pointer, which stays 16-byte aligned
+    int frame_size = (allocation->frame_slots * 8 + 15) / 16 * 16 + 32;
+    append_code(context, "    push rbp\n");
+    append_code(context, "    mov rbp, rsp\n");
+    append_code(context, "    and rsp, -16\n");
+    append_code(context, "    sub rsp, %d\n", frame_size);
+
+    // A variable read before it is first written starts from zero; .bss
+    // cells already are
+    Liveness *liveness = compute_liveness(build_cfg(tac));
+    for (int v = 0; v < liveness->value_count; v++)
     {
+        if (!liveness_contains(liveness->live_in, v))
+            continue;
+        if (allocation->location[v] != REG_NONE)
+            append_code(context, "    xor %s, %s\n", machine_registers[allocation->location[v]].name,
+                        machine_registers[allocation->location[v]].name);
+        else if (allocation->slot[v] >= 0)
+            append_code(context, "    mov qword %s, 0\n", context->addresses[v]);
+    }
+
+    for (int i = 0; i < tac->count; i++)
+    {
+        const TAC *current = &tac->code[i];
+
         switch (current->op)
         {
         case TAC_ASSIGN:
-            if (current->arg1[0] == '"') 
-            {  
-                strcpy(string_vars[string_var_count++], current->result);
-                append_code(context, "    lea rax, [rel string_%d]\n", string_count);
-                append_code(context, "    mov [%s], rax\n", current->result);
-                string_count++;
-            }
-            else if (isdigit(current->arg1[0]) || current->arg1[0] == '-') 
-            {
-                append_code(context, "    mov rax, %s\n", current->arg1);
-                append_code(context, "    mov [%s], rax\n", current->result);
-            }
-            else 
-            {
-                
-                int source_is_string = 0;
-                for (int i = 0; i < string_var_count; i++)
-                {
-                    if (strcmp(string_vars[i], current->arg1) == 0)
-                    {
-                        source_is_string = 1;
-                        strcpy(string_vars[string_var_count++], current->result);
-                        break;
-                    }
-                }
-
-                append_code(context, "    mov rax, [%s]\n", current->arg1);
-                append_code(context, "    mov [%s], rax\n", current->result);
-            }
+        {
+            const char *target = result_register(context, tac, current->result);
+            const char *from = register_of(context, tac, current->arg1);
+            if (from != NULL && strcmp(target, "rax") == 0)
+                target = from;
+            else
+                load_operand(context, tac, target, current->arg1);
+            store_result(context, tac, current->result, target);
             break;
+        }
 
         case TAC_CALL:
-            if (strcmp(current->arg1, "show") == 0)
+            if (current->arg1.id == NAME_SHOW)
             {
-                char *arg = current->arg2;
-                if (arg[0] == '"')
-                {
-                    char string_content[256];
-                    strncpy(string_content, arg + 1, strlen(arg) - 2);
-                    string_content[strlen(arg) - 2] = '\0';
-                    append_code(context, "    section .data\n");
-                    append_code(context, "    temp_string_%d: db \"%s\", 0\n", string_count, string_content);
-                    append_code(context, "    section .text\n");
-                    append_code(context, "    lea rcx, [rel temp_string_%d]\n", string_count);
+                // The call carries its argument's type
+                load_operand(context, tac, "rcx", current->arg2);
+                if (current->type == TYPE_STR)
                     append_code(context, "    call show_str\n");
-                    string_count++;
-                }
-                else if (isdigit(arg[0]) || (arg[0] == '-' && isdigit(arg[1])))
-                {
-                    append_code(context, "    mov rcx, %s\n", arg);
-                    append_code(context, "    call show_num\n");
-                }
                 else
-                {
-                    int is_string_var = 0;
-                    for (int i = 0; i < string_var_count; i++)
-                    {
-                        if (strcmp(string_vars[i], arg) == 0)
-                        {
-                            is_string_var = 1;
-                            break;
-                        }
-                    }
-
-                    if (is_string_var)
-                    {
-                        
-                        append_code(context, "    mov rcx, [%s]\n", arg);
-                        append_code(context, "    call show_str\n");
-                    }
-                    else
-                    {
-                        
-                        append_code(context, "    mov rcx, [%s]\n", arg);
-                        append_code(context, "    call show_num\n");
-                    }
-                }
+                    append_code(context, "    call show_num\n");
+            }
+            else if (register_of(context, tac, current->result) != NULL)
+            {
+                // ask has no runtime support yet; its result reads as zero
+                append_code(context, "    xor %s, %s\n", register_of(context, tac, current->result),
+                            register_of(context, tac, current->result));
+            }
+            else if (memory_of(context, tac, current->result) != NULL)
+            {
+                append_code(context, "    mov qword %s, 0\n", memory_of(context, tac, current->result));
             }
             break;
 
         case TAC_ADD:
-            append_code(context, "    mov rax, [%s]\n", current->arg1);
-            append_code(context, "    add rax, [%s]\n", current->arg2);
-            append_code(context, "    mov [%s], rax\n", current->result);
+            emit_arithmetic(context, tac, current, "add");
             break;
 
         case TAC_SUB:
-            append_code(context, "    mov rax, [%s]\n", current->arg1);
-            append_code(context, "    sub rax, [%s]\n", current->arg2);
-            append_code(context, "    mov [%s], rax\n", current->result);
+            emit_arithmetic(context, tac, current, "sub");
             break;
 
         case TAC_MUL:
-            append_code(context, "    mov rax, [%s]\n", current->arg1);
-            append_code(context, "    imul rax, [%s]\n", current->arg2);
-            append_code(context, "    mov [%s], rax\n", current->result);
+            emit_arithmetic(context, tac, current, "imul");
             break;
 
         case TAC_DIV:
-            append_code(context, "    mov rax, [%s]\n", current->arg1);
+            load_operand(context, tac, "rax", current->arg1);
             append_code(context, "    cqo\n");
-            append_code(context, "    idiv qword [%s]\n", current->arg2);
-            append_code(context, "    mov [%s], rax\n", current->result);
-            break;
-
-        case TAC_GREATER: 
-            append_code(context, "    mov rax, [%s]\n", current->arg1);
-            append_code(context, "    cmp rax, [%s]\n", current->arg2);
-            append_code(context, "    setg al\n");       
-            append_code(context, "    movzx rax, al\n"); 
-            append_code(context, "    mov [%s], rax\n", current->result);
-            break;
-
-        case TAC_LESS: 
-            append_code(context, "    mov rax, [%s]\n", current->arg1);
-            append_code(context, "    cmp rax, [%s]\n", current->arg2);
-            append_code(context, "    setl al\n");       
-            append_code(context, "    movzx rax, al\n"); 
-            append_code(context, "    mov [%s], rax\n", current->result);
-            break;
-
-        case TAC_EQ: 
-            append_code(context, "    mov rax, [%s]\n", current->arg1);
-            append_code(context, "    cmp rax, [%s]\n", current->arg2);
-            append_code(context, "    sete al\n");       
-            append_code(context, "    movzx rax, al\n"); 
-            append_code(context, "    mov [%s], rax\n", current->result);
-            break;
-
-        case TAC_NEQ: 
-            append_code(context, "    mov rax, [%s]\n", current->arg1);
-            append_code(context, "    cmp rax, [%s]\n", current->arg2);
-            append_code(context, "    setne al\n");      
-            append_code(context, "    movzx rax, al\n"); 
-            append_code(context, "    mov [%s], rax\n", current->result);
-            break;
-
-        case TAC_GREATER_EQ: 
-            append_code(context, "    mov rax, [%s]\n", current->arg1);
-            append_code(context, "    cmp rax, [%s]\n", current->arg2);
-            append_code(context, "    setge al\n");      
-            append_code(context, "    movzx rax, al\n"); 
-            append_code(context, "    mov [%s], rax\n", current->result);
+            if (register_of(context, tac, current->arg2) != NULL)
+            {
+                append_code(context, "    idiv %s\n", register_of(context, tac, current->arg2));
+            }
+            else if (memory_of(context, tac, current->arg2) != NULL)
+            {
+                append_code(context, "    idiv qword %s\n", memory_of(context, tac, current->arg2));
+            }
+            else
+            {
+                load_operand(context, tac, "rcx", current->arg2);
+                append_code(context, "    idiv rcx\n");
+            }
+            store_result(context, tac, current->result, "rax");
             break;
 
-        case TAC_LESS_EQ: 
-            append_code(context, "    mov rax, [%s]\n", current->arg1);
-            append_code(context, "    cmp rax, [%s]\n", current->arg2);
-            append_code(context, "    setle al\n");      
-            append_code(context, "    movzx rax, al\n"); 
-            append_code(context, "    mov [%s], rax\n", current->result);
+        case TAC_GREATER:
+        case TAC_LESS:
+        case TAC_EQ:
+        case TAC_NEQ:
+        case TAC_GREATER_EQ:
+        case TAC_LESS_EQ:
+            // A comparison feeding the branch right after it branches on its own flags
+            if (i + 1 < tac->count && tac->code[i + 1].op == TAC_IF &&
+                operand_equal(tac->code[i + 1].arg1, current->result))
+            {
+                const uint64_t *live_out = &liveness->live_out[liveness->cfg->block_of[i + 1] * liveness->words];
+                emit_compare(context, tac, current, liveness_contains(live_out, liveness_value(tac, current->result)));
+                i = emit_branch(context, tac, i + 1, current->op);
+            }
+            else
+            {
+                emit_compare(context, tac, current, true);
+            }
             break;
 
         case TAC_IF:
-            append_code(context, "    mov rax, [%s]\n", current->arg1);
-            append_code(context, "    cmp rax, 0\n");
-            append_code(context, "    jne %s\n", current->result);
+            if (register_of(context, tac, current->arg1) != NULL)
+            {
+                append_code(context, "    cmp %s, 0\n", register_of(context, tac, current->arg1));
+            }
+            else
+            {
+                load_operand(context, tac, "rax", current->arg1);
+                append_code(context, "    cmp rax, 0\n");
+            }
+            i = emit_branch(context, tac, i, TAC_NEQ);
             break;
 
         case TAC_GOTO:
-            append_code(context, "    jmp %s\n", current->result);
+            if (!label_follows(tac, i, current->result))
+                append_code(context, "    jmp %s\n", symbol_name(tac, current->result, symbol));
             break;
 
         case TAC_LABEL:
-            append_code(context, "%s:\n", current->result);
+            append_code(context, "%s:\n", symbol_name(tac, current->result, symbol));
             break;
 
         default:
             break;
         }
-        current = current->next;
     }
 
     // Exit process call at the end
     append_code(context, "\n    mov rcx, 0\n");
     append_code(context, "    call process_exit\n");
 
-    char *result = strdup(context->output);
-    free_gen_context(context);
-    return result;
-}
+    return context->output;
+}
\ No newline at end of file
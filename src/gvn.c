@@ -0,0 +1,171 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../include/optimizer.h"
+#include "../include/ssa.h"
+
+// Dominator-based value numbering. Every SSA value gets a number; a copy shares
+// the number of what it copies, and a pure computation shares the number of an
+// identical computation (same operator, same numbered operands) in a block that
+// dominates it, or earlier in its own block. A computation found again is
+// replaced by a copy of the temp that already holds its value, which copy
+// propagation and dead temp removal then fold away. Working on SSA versions
+// means an assignment between two computations of x + 1 tells them apart
+// without any kill sets.
+
+typedef struct
+{
+    TACOpType op;
+    Operand a; // OPERAND_TEMP holding a value number, or a constant
+    Operand b;
+    int number;
+    Operand leader; // temp holding the value, or OPERAND_NONE
+    int block;
+    int next;
+} Expression;
+
+typedef struct
+{
+    const Cfg *cfg;
+    const Ssa *ssa;
+    int *number; // value number of each SSA value
+    int *buckets;
+    uint32_t mask;
+    Expression *expressions;
+    int count;
+} ValueTable;
+
+static Operand numbered(const ValueTable *table, Operand operand, int value)
+{
+    if (value >= 0)
+        return make_operand(OPERAND_TEMP, (uint32_t)table->number[value]);
+    return operand;
+}
+
+static uint32_t hash_operand(Operand operand)
+{
+    uint64_t bits = operand.kind == OPERAND_IMM ? (uint64_t)operand.imm : operand.id;
+    return (uint32_t)operand.kind * 31u + (uint32_t)(bits ^ (bits >> 32));
+}
+
+static uint32_t hash_expression(TACOpType op, Operand a, Operand b)
+{
+    return ((uint32_t)op * 0x9e3779b9u) ^ (hash_operand(a) * 0x85ebca6bu) ^ (hash_operand(b) * 0xc2b2ae35u);
+}
+
+static bool is_commutative(TACOpType op)
+{
+    return op == TAC_ADD || op == TAC_MUL || op == TAC_EQ || op == TAC_NEQ;
+}
+
+// An identical computation visible from block, preferring one held in a temp
+static Expression *find(ValueTable *table, uint32_t hash, TACOpType op, Operand a, Operand b, int block)
+{
+    Expression *found = NULL;
+    for (int e = table->buckets[hash & table->mask]; e >= 0; e = table->expressions[e].next)
+    {
+        Expression *expression = &table->expressions[e];
+        if (expression->op != op || !operand_equal(expression->a, a) || !operand_equal(expression->b, b) ||
+            !cfg_dominates(table->cfg, expression->block, block))
+            continue;
+        if (expression->leader.kind == OPERAND_TEMP)
+            return expression;
+        found = expression;
+    }
+    return found;
+}
+
+static void add(ValueTable *table, uint32_t hash, TACOpType op, Operand a, Operand b, int number, Operand leader,
+                int block)
+{
+    Expression *expression = &table->expressions[table->count];
+    expression->op = op;
+    expression->a = a;
+    expression->b = b;
+    expression->number = number;
+    expression->leader = leader;
+    expression->block = block;
+    expression->next = table->buckets[hash & table->mask];
+    table->buckets[hash & table->mask] = table->count++;
+}
+
+int number_values(TacBuffer *tac, OptimizerStats *stats)
+{
+    if (tac->count == 0)
+        return 0;
+
+    ValueTable table;
+    table.cfg = build_cfg(tac);
+    table.ssa = build_ssa(table.cfg);
+    table.number = (int *)region_alloc(REGION_IR, (table.ssa->value_count + 1) * sizeof(int));
+    for (int v = 0; v < table.ssa->value_count; v++)
+        table.number[v] = v;
+
+    uint32_t size = 16;
+    while (size < (uint32_t)tac->count * 2)
+        size *= 2;
+    table.mask = size - 1;
+    table.buckets = (int *)region_alloc(REGION_IR, size * sizeof(int));
+    memset(table.buckets, 0xff, size * sizeof(int));
+    table.expressions = (Expression *)region_alloc(REGION_IR, (tac->count + 1) * sizeof(Expression));
+    table.count = 0;
+
+    const Cfg *cfg = table.cfg;
+    const Ssa *ssa = table.ssa;
+    int changes = 0;
+
+    // Reverse postorder visits a block's dominators before the block
+    for (int o = 0; o < cfg->order_count; o++)
+    {
+        int b = cfg->order[o];
+        for (int i = cfg->blocks[b].first; i < cfg->blocks[b].last; i++)
+        {
+            TAC *code = &tac->code[i];
+            int result = ssa->def_value[i];
+            if (result < 0)
+                continue;
+
+            Operand left = numbered(&table, code->arg1, ssa->use_value[i * 2]);
+            if (code->op == TAC_ASSIGN)
+            {
+                if (left.kind == OPERAND_TEMP)
+                    table.number[result] = (int)left.id;
+                continue;
+            }
+            if (!tac_is_pure(code))
+                continue;
+
+            Operand right = numbered(&table, code->arg2, ssa->use_value[i * 2 + 1]);
+            if (is_commutative(code->op) && hash_operand(left) > hash_operand(right))
+            {
+                Operand swap = left;
+                left = right;
+                right = swap;
+            }
+
+            uint32_t hash = hash_expression(code->op, left, right);
+            Expression *earlier = find(&table, hash, code->op, left, right, b);
+            Operand leader = code->result.kind == OPERAND_TEMP ? code->result : NO_OPERAND;
+            if (earlier == NULL)
+            {
+                add(&table, hash, code->op, left, right, result, leader, cfg->block_of[i]);
+                continue;
+            }
+
+            table.number[result] = earlier->number;
+            if (earlier->leader.kind == OPERAND_TEMP)
+            {
+                code->op = TAC_ASSIGN;
+                code->arg1 = earlier->leader;
+                code->arg2 = NO_OPERAND;
+                stats->redundant++;
+                changes++;
+            }
+            else if (leader.kind == OPERAND_TEMP)
+            {
+                add(&table, hash, code->op, left, right, earlier->number, leader, cfg->block_of[i]);
+            }
+        }
+    }
+    return changes;
+}
\ No newline at end of file
@@ -0,0 +1,361 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../include/optimizer.h"
+#include "../include/cfg.h"
+
+// Induction variables and strength reduction. A basic induction variable is
+// a variable whose every assignment inside a loop is v = v + c or v = v - c
+// with a constant c. A product v * k inside the loop is replaced by a new
+// variable kept equal to v * k: it is set in front of the loop and stepped by
+// c * k right after each update of v. Arithmetic wraps, so the running sum
+// matches the product even when it overflows.
+//
+// When the loop's exit test compares v with a constant and v's range can be
+// bounded, the test is rewritten against the new variable; if nothing else
+// reads v afterwards, v and its updates are removed.
+
+typedef struct
+{
+    int at;   // instruction the code follows, or block it is placed in front of
+    TAC code;
+    int next;
+} Insertion;
+
+typedef struct
+{
+    TacBuffer *tac;
+    const Cfg *cfg;
+    Insertion *items;
+    int count;
+    int capacity;
+    int *before_block; // first insertion in front of each block
+    int *after_code;   // first insertion after each instruction
+    int *tail_block;
+    int *tail_code;
+} Insertions;
+
+typedef struct
+{
+    SlotId var;
+    int64_t factor;
+    SlotId reduced; // variable holding var * factor
+} Product;
+
+static void insert(Insertions *list, int *head, int *tail, int at, TACOpType op, Operand result, Operand arg1,
+                   Operand arg2, int offset)
+{
+    if (list->count >= list->capacity)
+    {
+        int grown = list->capacity ? list->capacity * 2 : 16;
+        list->items = (Insertion *)region_grow(REGION_IR, list->items, list->capacity * sizeof(Insertion),
+                                               grown * sizeof(Insertion));
+        list->capacity = grown;
+    }
+
+    Insertion *item = &list->items[list->count];
+    item->at = at;
+    item->code.op = op;
+    item->code.result = result;
+    item->code.arg1 = arg1;
+    item->code.arg2 = arg2;
+    item->code.offset = offset;
+    item->code.type = TYPE_NUM;
+    item->next = -1;
+
+    if (head[at] < 0)
+        head[at] = list->count;
+    else
+        list->items[tail[at]].next = list->count;
+    tail[at] = list->count++;
+}
+
+static bool is_comparison(TACOpType op)
+{
+    return op == TAC_LESS || op == TAC_LESS_EQ || op == TAC_GREATER || op == TAC_GREATER_EQ;
+}
+
+// a OP b is b MIRROR(OP) a
+static TACOpType mirror(TACOpType op)
+{
+    switch (op)
+    {
+    case TAC_LESS:
+        return TAC_GREATER;
+    case TAC_LESS_EQ:
+        return TAC_GREATER_EQ;
+    case TAC_GREATER:
+        return TAC_LESS;
+    default:
+        return TAC_LESS_EQ;
+    }
+}
+
+static SlotId create_reduced_var(SlotTable *slots, SlotId var)
+{
+    char name[256];
+    snprintf(name, sizeof(name), "%s.%u", name_str(slots->slots[var].label), slots->count);
+    return slot_table_bind(slots, intern_cstr(name), TYPE_NUM);
+}
+
+// Rewrites the loop's exit test on var against product->reduced. The header
+// must end in a branch that stays in the loop while var < n (or <=, >, >=)
+// holds, var must move towards n by one update per iteration, and every value
+// var can take at the test, times the factor, must fit in 64 bits.
+static bool replace_exit_test(TacBuffer *tac, const Cfg *cfg, int l, const Product *product, int update, int64_t step)
+{
+    const Loop *loop = &cfg->loops[l];
+    const BasicBlock *header = &cfg->blocks[loop->header];
+    const TAC *branch = &tac->code[header->last - 1];
+    int64_t initial;
+
+    if (cfg->blocks[cfg->block_of[update]].loop != l || cfg->block_of[update] == loop->header)
+        return false;
+    const BasicBlock *preheader = &cfg->blocks[cfg_preheader(cfg, l)];
+    if (!tac_constant_before(tac, preheader->first, preheader->last, product->var, &initial))
+        return false;
+    if (branch->op != TAC_IF || branch->arg1.kind != OPERAND_TEMP || header->succ_count != 2 ||
+        !cfg_loop_contains(cfg, l, header->succs[0]) || cfg_loop_contains(cfg, l, header->succs[1]))
+        return false;
+
+    TAC *test = NULL;
+    for (int i = header->first; i < header->last; i++)
+    {
+        if (operand_equal(tac->code[i].result, branch->arg1))
+            test = &tac->code[i];
+    }
+    if (test == NULL || !is_comparison(test->op))
+        return false;
+
+    // Normalise to var OP limit
+    Operand var = make_operand(OPERAND_VAR, product->var);
+    TACOpType op = test->op;
+    int64_t limit;
+    if (operand_equal(test->arg1, var) && test->arg2.kind == OPERAND_IMM)
+        limit = test->arg2.imm;
+    else if (operand_equal(test->arg2, var) && test->arg1.kind == OPERAND_IMM)
+    {
+        limit = test->arg1.imm;
+        op = mirror(op);
+    }
+    else
+        return false;
+
+    // The last value that stays in the loop, stepped once more, bounds var
+    int64_t last, low, high;
+    bool ascending = op == TAC_LESS || op == TAC_LESS_EQ;
+    if (ascending != (step > 0))
+        return false;
+    if (op == TAC_LESS || op == TAC_GREATER)
+    {
+        if (__builtin_sub_overflow(limit, ascending ? 1 : -1, &last))
+            return false;
+    }
+    else
+        last = limit;
+    if (__builtin_add_overflow(last, step, &last))
+        return false;
+    low = ascending ? initial : (last < initial ? last : initial);
+    high = ascending ? (last > initial ? last : initial) : initial;
+
+    int64_t scaled;
+    if (__builtin_mul_overflow(low, product->factor, &scaled) ||
+        __builtin_mul_overflow(high, product->factor, &scaled) ||
+        __builtin_mul_overflow(limit, product->factor, &scaled))
+        return false;
+
+    test->op = product->factor > 0 ? op : mirror(op);
+    test->arg1 = make_operand(OPERAND_VAR, product->reduced);
+    test->arg2 = make_imm(scaled);
+    return true;
+}
+
+// Removes every assignment to var once nothing reads it, counting the
+// setup of products not yet inserted
+static int remove_variable(TacBuffer *tac, const Insertions *list, SlotId var)
+{
+    for (int n = 0; n < list->count; n++)
+    {
+        if (list->items[n].code.arg1.kind == OPERAND_VAR && list->items[n].code.arg1.id == var)
+            return 0;
+    }
+    for (int i = 0; i < tac->count; i++)
+    {
+        const TAC *code = &tac->code[i];
+        if ((code->arg1.kind == OPERAND_VAR && code->arg1.id == var) ||
+            (code->arg2.kind == OPERAND_VAR && code->arg2.id == var))
+        {
+            int64_t step;
+            if (code->result.kind != OPERAND_VAR || code->result.id != var || !tac_induction_step(code, &step))
+                return 0;
+        }
+    }
+
+    int removed = 0;
+    for (int i = 0; i < tac->count; i++)
+    {
+        TAC *code = &tac->code[i];
+        if (code->result.kind == OPERAND_VAR && code->result.id == var && (code->op == TAC_ASSIGN || tac_is_pure(code)))
+        {
+            code->op = TAC_NOP;
+            removed++;
+        }
+    }
+    return removed;
+}
+
+int reduce_induction(TacBuffer *tac, OptimizerStats *stats)
+{
+    if (tac->count == 0)
+        return 0;
+
+    Cfg *cfg = build_cfg(tac);
+    if (cfg->loop_count == 0)
+        return 0;
+
+    int count = tac->count;
+    uint32_t var_count = tac->slots->count;
+    int *seen = (int *)region_calloc(REGION_IR, var_count + 1, sizeof(int));
+    int *update = (int *)region_alloc(REGION_IR, (var_count + 1) * sizeof(int));     // -1 if not an induction variable
+    int64_t *step = (int64_t *)region_alloc(REGION_IR, (var_count + 1) * sizeof(int64_t));
+    bool *reduced = (bool *)region_calloc(REGION_IR, count + 1, sizeof(bool));
+    Product *products = (Product *)region_alloc(REGION_IR, (count + 1) * sizeof(Product));
+    int changes = 0;
+
+    Insertions list;
+    memset(&list, 0, sizeof(list));
+    list.tac = tac;
+    list.cfg = cfg;
+    list.before_block = (int *)region_alloc(REGION_IR, (cfg->block_count + 1) * sizeof(int));
+    list.tail_block = (int *)region_alloc(REGION_IR, (cfg->block_count + 1) * sizeof(int));
+    list.after_code = (int *)region_alloc(REGION_IR, (count + 1) * sizeof(int));
+    list.tail_code = (int *)region_alloc(REGION_IR, (count + 1) * sizeof(int));
+    for (int b = 0; b < cfg->block_count; b++)
+        list.before_block[b] = -1;
+    for (int i = 0; i < count; i++)
+        list.after_code[i] = -1;
+
+    // Innermost loops first, so a product is reduced in the loop that steps it
+    for (int l = cfg->loop_count - 1; l >= 0; l--)
+    {
+        const Loop *loop = &cfg->loops[l];
+        int mark = l + 1;
+        int preheader = cfg_preheader(cfg, l);
+        if (preheader < 0)
+            continue;
+
+        for (int b = 0; b < loop->block_count; b++)
+        {
+            const BasicBlock *block = &cfg->blocks[loop->blocks[b]];
+            for (int i = block->first; i < block->last; i++)
+            {
+                const TAC *code = &tac->code[i];
+                if (code->result.kind != OPERAND_VAR)
+                    continue;
+                SlotId var = code->result.id;
+                int64_t delta;
+                bool first = seen[var] != mark;
+                seen[var] = mark;
+                if (first && tac_induction_step(code, &delta))
+                {
+                    update[var] = i;
+                    step[var] = delta;
+                }
+                else
+                    update[var] = -1;
+            }
+        }
+
+        int product_count = 0;
+        for (int b = 0; b < loop->block_count; b++)
+        {
+            const BasicBlock *block = &cfg->blocks[loop->blocks[b]];
+            for (int i = block->first; i < block->last; i++)
+            {
+                TAC *code = &tac->code[i];
+                if (code->op != TAC_MUL || reduced[i])
+                    continue;
+
+                Operand var = code->arg1.kind == OPERAND_VAR ? code->arg1 : code->arg2;
+                Operand factor = code->arg1.kind == OPERAND_VAR ? code->arg2 : code->arg1;
+                if (var.kind != OPERAND_VAR || factor.kind != OPERAND_IMM || factor.imm == 0 || factor.imm == 1 ||
+                    seen[var.id] != mark || update[var.id] < 0)
+                    continue;
+
+                int p = 0;
+                while (p < product_count && (products[p].var != var.id || products[p].factor != factor.imm))
+                    p++;
+                if (p == product_count)
+                {
+                    Product *product = &products[product_count++];
+                    product->var = var.id;
+                    product->factor = factor.imm;
+                    product->reduced = create_reduced_var(tac->slots, var.id);
+
+                    Operand reduced_var = make_operand(OPERAND_VAR, product->reduced);
+                    int64_t initial, delta;
+                    const BasicBlock *entry = &cfg->blocks[preheader];
+                    if (tac_constant_before(tac, entry->first, entry->last, var.id, &initial))
+                    {
+                        tac_evaluate(TAC_MUL, initial, factor.imm, &initial);
+                        insert(&list, list.before_block, list.tail_block, loop->header, TAC_ASSIGN, reduced_var,
+                               make_imm(initial), NO_OPERAND, code->offset);
+                    }
+                    else
+                        insert(&list, list.before_block, list.tail_block, loop->header, TAC_MUL, reduced_var,
+                               var, factor, code->offset);
+                    tac_evaluate(TAC_MUL, step[var.id], factor.imm, &delta);
+                    insert(&list, list.after_code, list.tail_code, update[var.id], TAC_ADD, reduced_var,
+                           reduced_var, make_imm(delta), tac->code[update[var.id]].offset);
+                }
+
+                code->op = TAC_ASSIGN;
+                code->arg1 = make_operand(OPERAND_VAR, products[p].reduced);
+                code->arg2 = NO_OPERAND;
+                reduced[i] = true;
+                stats->reduced++;
+                changes++;
+            }
+        }
+
+        // One product per variable is enough to carry the exit test
+        for (int p = 0; p < product_count; p++)
+        {
+            SlotId var = products[p].var;
+            if (seen[var] != mark)
+                continue;
+            seen[var] = 0;
+            if (replace_exit_test(tac, cfg, l, &products[p], update[var], step[var]))
+            {
+                int removed = remove_variable(tac, &list, var);
+                stats->eliminated += removed > 0;
+                changes += removed + 1;
+            }
+        }
+    }
+
+    if (list.count == 0 && changes == 0)
+        return 0;
+
+    // Re-emit the code with the new variables' setup and steps in place
+    TAC *old = (TAC *)region_alloc(REGION_IR, count * sizeof(TAC));
+    memcpy(old, tac->code, count * sizeof(TAC));
+    tac->count = 0;
+
+    for (int b = 0; b < cfg->block_count; b++)
+    {
+        for (int n = list.before_block[b]; n >= 0; n = list.items[n].next)
+            tac_emit(tac, list.items[n].code.op, list.items[n].code.result, list.items[n].code.arg1,
+                     list.items[n].code.arg2, list.items[n].code.offset);
+
+        for (int i = cfg->blocks[b].first; i < cfg->blocks[b].last; i++)
+        {
+            TAC *copy = tac_emit(tac, old[i].op, old[i].result, old[i].arg1, old[i].arg2, old[i].offset);
+            copy->type = old[i].type;
+            for (int n = list.after_code[i]; n >= 0; n = list.items[n].next)
+                tac_emit(tac, list.items[n].code.op, list.items[n].code.result, list.items[n].code.arg1,
+                         list.items[n].code.arg2, list.items[n].code.offset);
+        }
+    }
+    return changes;
+}
\ No newline at end of file
@@ -0,0 +1,201 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../include/intern.h"
+
+#define INITIAL_NAME_CAPACITY 256
+#define TEXT_BLOCK_SIZE 65536
+
+typedef struct
+{
+    const char *text;
+    uint32_t length;
+    uint32_t hash;
+} NameEntry;
+
+// Name text lives in fixed blocks that are never moved, so name_str pointers stay valid
+typedef struct TextBlock
+{
+    struct TextBlock *next;
+    size_t used;
+    size_t size;
+    char data[];
+} TextBlock;
+
+static NameEntry *names = NULL; // indexed by NameId; slot 0 is NAME_NONE
+static uint32_t count = 0;
+static uint32_t capacity = 0;
+static NameId *table = NULL; // open addressing, 0 marks an empty slot
+static uint32_t table_size = 0;
+static TextBlock *blocks = NULL;
+
+static uint32_t hash_text(const char *text, int length)
+{
+    // FNV-1a
+    uint32_t hash = 2166136261u;
+    for (int i = 0; i < length; i++)
+    {
+        hash ^= (unsigned char)text[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static void *checked_alloc(void *ptr)
+{
+    if (!ptr)
+    {
+        fprintf(stderr, "Error: Memory allocation failed for name table\n");
+        exit(1);
+    }
+    return ptr;
+}
+
+static const char *store_text(const char *text, int length)
+{
+    if (!blocks || blocks->size - blocks->used < (size_t)length + 1)
+    {
+        size_t size = (size_t)length + 1 > TEXT_BLOCK_SIZE ? (size_t)length + 1 : TEXT_BLOCK_SIZE;
+        TextBlock *block = (TextBlock *)checked_alloc(malloc(sizeof(TextBlock) + size));
+        block->next = blocks;
+        block->used = 0;
+        block->size = size;
+        blocks = block;
+    }
+
+    char *copy = blocks->data + blocks->used;
+    memcpy(copy, text, length);
+    copy[length] = '\0';
+    blocks->used += (size_t)length + 1;
+    return copy;
+}
+
+static void grow_table(void)
+{
+    uint32_t new_size = table_size ? table_size * 2 : INITIAL_NAME_CAPACITY * 2;
+    NameId *new_table = (NameId *)checked_alloc(calloc(new_size, sizeof(NameId)));
+
+    for (NameId id = 1; id < count; id++)
+    {
+        uint32_t slot = names[id].hash & (new_size - 1);
+        while (new_table[slot] != NAME_NONE)
+            slot = (slot + 1) & (new_size - 1);
+        new_table[slot] = id;
+    }
+
+    free(table);
+    table = new_table;
+    table_size = new_size;
+}
+
+static void intern_init(void)
+{
+    capacity = INITIAL_NAME_CAPACITY;
+    names = (NameEntry *)checked_alloc(malloc(capacity * sizeof(NameEntry)));
+    names[0].text = "";
+    names[0].length = 0;
+    names[0].hash = 0;
+    count = 1;
+    grow_table();
+
+    intern_cstr("num");
+    intern_cstr("str");
+    intern_cstr("show");
+    intern_cstr("ask");
+}
+
+NameId intern(const char *text, int length)
+{
+    if (!names)
+        intern_init();
+
+    uint32_t hash = hash_text(text, length);
+    uint32_t slot = hash & (table_size - 1);
+    while (table[slot] != NAME_NONE)
+    {
+        NameEntry *entry = &names[table[slot]];
+        if (entry->hash == hash && entry->length == (uint32_t)length &&
+            memcmp(entry->text, text, length) == 0)
+            return table[slot];
+        slot = (slot + 1) & (table_size - 1);
+    }
+
+    if (count >= capacity)
+    {
+        capacity *= 2;
+        names = (NameEntry *)checked_alloc(realloc(names, capacity * sizeof(NameEntry)));
+    }
+
+    NameId id = count++;
+    names[id].text = store_text(text, length);
+    names[id].length = (uint32_t)length;
+    names[id].hash = hash;
+    table[slot] = id;
+
+    // Keep the load factor at or below one half
+    if (count * 2 > table_size)
+        grow_table();
+
+    return id;
+}
+
+// Look a name up without adding it; NAME_NONE if it was never interned
+NameId intern_find(const char *text, int length)
+{
+    if (!names)
+        intern_init();
+
+    uint32_t hash = hash_text(text, length);
+    uint32_t slot = hash & (table_size - 1);
+    while (table[slot] != NAME_NONE)
+    {
+        NameEntry *entry = &names[table[slot]];
+        if (entry->hash == hash && entry->length == (uint32_t)length &&
+            memcmp(entry->text, text, length) == 0)
+            return table[slot];
+        slot = (slot + 1) & (table_size - 1);
+    }
+    return NAME_NONE;
+}
+
+NameId intern_cstr(const char *text)
+{
+    return intern(text, (int)strlen(text));
+}
+
+const char *name_str(NameId id)
+{
+    if (!names)
+        intern_init();
+    return names[id].text;
+}
+
+int name_length(NameId id)
+{
+    if (!names)
+        intern_init();
+    return (int)names[id].length;
+}
+
+// One past the largest ID handed out, for sizing arrays indexed by NameId
+uint32_t name_count(void)
+{
+    if (!names)
+        intern_init();
+    return count;
+}
+
+void intern_free(void)
+{
+    while (blocks)
+    {
+        TextBlock *next = blocks->next;
+        free(blocks);
+        blocks = next;
+    }
+    free(names);
+    free(table);
+    names = NULL;
+    table = NULL;
+    count = capacity = table_size = 0;
+}
\ No newline at end of file
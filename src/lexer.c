@@ -3,15 +3,26 @@
 #include <string.h>
 #include <ctype.h>
 #include "../include/lexer.h"
+#include "../include/scan.h"
 
-Lexer *create_lexer(char *source)
+#define INITIAL_TOKEN_CAPACITY 256
+
+// Past the end of the buffer the lexer sees '\0', as it would for a C string
+static char lexer_char_at(Lexer *lexer, int position)
+{
+    return position < lexer->length ? lexer->source[position] : '\0';
+}
+
+// The lexer works directly on the caller's buffer; nothing is copied
+Lexer *create_lexer(SourceBuffer *buffer)
 {
-    Lexer *lexer = (Lexer *)malloc(sizeof(Lexer));
-    lexer->source = strdup(source);
+    Lexer *lexer = (Lexer *)region_alloc(REGION_TOKENS, sizeof(Lexer));
+    lexer->buffer = buffer;
+    lexer->source = buffer->text;
+    lexer->length = (int)buffer->length;
     lexer->position = 0;
-    lexer->line = 1;
-    lexer->column = 1;
-    lexer->current_char = lexer->source[0];
+    lexer->current_char = lexer_char_at(lexer, 0);
+    scan_init();
     return lexer;
 }
 
@@ -20,87 +31,74 @@ void lexer_advance(Lexer *lexer)
     if (lexer->current_char != '\0')
     {
         lexer->position++;
-        lexer->column++;
-        if (lexer->current_char == '\n')
-        {
-            lexer->line++;
-            lexer->column = 1;
-        }
-        lexer->current_char = lexer->source[lexer->position];
+        lexer->current_char = lexer_char_at(lexer, lexer->position);
     }
 }
 
+// Move forward count bytes at once
+static void lexer_skip(Lexer *lexer, int count)
+{
+    lexer->position += count;
+    lexer->current_char = lexer_char_at(lexer, lexer->position);
+}
+
+// Remaining unlexed bytes starting at the current position
+static size_t lexer_remaining(Lexer *lexer)
+{
+    return (size_t)(lexer->length - lexer->position);
+}
+
 void lexer_skip_whitespace(Lexer *lexer)
 {
-    while (lexer->current_char != '\0' && isspace(lexer->current_char))
-    {
-        lexer_advance(lexer);
-    }
+    lexer_skip(lexer, (int)scanner.whitespace(lexer->source + lexer->position, lexer_remaining(lexer)));
 }
 
-Token *create_token(TokenType type, const char *value, int line, int column)
+static Token make_token(TokenType type, int offset, int length)
 {
-    Token *token = (Token *)malloc(sizeof(Token));
-    token->type = type;
-    token->value = value ? strdup(value) : NULL;
-    token->line = line;
-    token->column = column;
+    Token token;
+    token.type = type;
+    token.offset = (uint32_t)offset;
+    token.length = (uint32_t)length;
     return token;
 }
 
-char *lexer_collect_string(Lexer *lexer)
+// The collect helpers consume a lexeme and return its length; the text stays in the source
+int lexer_collect_string(Lexer *lexer)
 {
-    char *str = (char *)malloc(1024 * sizeof(char));
-    int i = 0;
+    int start = lexer->position;
 
     lexer_advance(lexer);
-
-    while (lexer->current_char != '"' && lexer->current_char != '\0')
-    {
-        str[i++] = lexer->current_char;
-        lexer_advance(lexer);
-    }
+    lexer_skip(lexer, (int)scanner.string_body(lexer->source + lexer->position, lexer_remaining(lexer)));
 
     if (lexer->current_char == '"')
     {
         lexer_advance(lexer);
     }
 
-    str[i] = '\0';
-    return str;
+    return lexer->position - start;
 }
 
-char *lexer_collect_number(Lexer *lexer)
+int lexer_collect_number(Lexer *lexer)
 {
-    char *num = (char *)malloc(256 * sizeof(char));
-    int i = 0;
+    int start = lexer->position;
 
     while (isdigit(lexer->current_char))
     {
-        num[i++] = lexer->current_char;
         lexer_advance(lexer);
     }
 
-    num[i] = '\0';
-    return num;
+    return lexer->position - start;
 }
 
-char *lexer_collect_identifier(Lexer *lexer)
+int lexer_collect_identifier(Lexer *lexer)
 {
-    char *identifier = (char *)malloc(256 * sizeof(char));
-    int i = 0;
-
-    while (isalnum(lexer->current_char) || lexer->current_char == '_')
-    {
-        identifier[i++] = lexer->current_char;
-        lexer_advance(lexer);
-    }
+    int length = (int)scanner.identifier(lexer->source + lexer->position, lexer_remaining(lexer));
 
-    identifier[i] = '\0';
-    return identifier;
+    lexer_skip(lexer, length);
+    return length;
 }
 
-Token *lexer_get_next_token(Lexer *lexer)
+Token lexer_get_next_token(Lexer *lexer)
 {
     while (lexer->current_char != '\0')
     {
@@ -110,48 +108,25 @@ Token *lexer_get_next_token(Lexer *lexer)
             continue;
         }
 
-        int current_line = lexer->line;
-        int current_column = lexer->column;
+        int start = lexer->position;
 
         if (isdigit(lexer->current_char))
         {
-            char *num = lexer_collect_number(lexer);
-            Token *token = create_token(TOKEN_NUMBER_LITERAL, num, current_line, current_column);
-            free(num);
-            return token;
+            int length = lexer_collect_number(lexer);
+            return make_token(TOKEN_NUMBER_LITERAL, start, length);
         }
 
         if (isalpha(lexer->current_char) || lexer->current_char == '_')
         {
-            char *identifier = lexer_collect_identifier(lexer);
-            TokenType type = TOKEN_IDENTIFIER;
-
-            if (strcmp(identifier, "num") == 0)
-                type = TOKEN_NUM;
-            else if (strcmp(identifier, "str") == 0)
-                type = TOKEN_STR;
-            else if (strcmp(identifier, "show") == 0)
-                type = TOKEN_SHOW;
-            else if (strcmp(identifier, "when") == 0)
-                type = TOKEN_WHEN;
-            else if (strcmp(identifier, "otherwise") == 0)
-                type = TOKEN_OTHERWISE;
-            else if (strcmp(identifier, "repeat") == 0)
-                type = TOKEN_REPEAT;
-            else if (strcmp(identifier, "ask") == 0)
-                type = TOKEN_ASK;
-
-            Token *token = create_token(type, identifier, current_line, current_column);
-            free(identifier);
-            return token;
+            int length = lexer_collect_identifier(lexer);
+            TokenType type = keyword_lookup(lexer->source + start, length);
+            return make_token(type, start, length);
         }
 
         if (lexer->current_char == '"')
         {
-            char *str = lexer_collect_string(lexer);
-            Token *token = create_token(TOKEN_STRING_LITERAL, str, current_line, current_column);
-            free(str);
-            return token;
+            int length = lexer_collect_string(lexer);
+            return make_token(TOKEN_STRING_LITERAL, start, length);
         }
         char current = lexer->current_char;
         lexer_advance(lexer);
@@ -159,73 +134,114 @@ Token *lexer_get_next_token(Lexer *lexer)
         switch (current)
         {
         case '+':
-            return create_token(TOKEN_PLUS, "+", current_line, current_column);
+            return make_token(TOKEN_PLUS, start, 1);
         case '-':
             if (isdigit(lexer->current_char))
             {
-                char *num = (char *)malloc(256 * sizeof(char));
-                int i = 0;
-                num[i++] = '-';
-
-                while (isdigit(lexer->current_char))
-                {
-                    num[i++] = lexer->current_char;
-                    lexer_advance(lexer);
-                }
-
-                num[i] = '\0';
-                Token *token = create_token(TOKEN_NUMBER_LITERAL, num, current_line, current_column);
-                free(num);
-                return token;
+                int length = 1 + lexer_collect_number(lexer);
+                return make_token(TOKEN_NUMBER_LITERAL, start, length);
             }
-            return create_token(TOKEN_MINUS, "-", current_line, current_column);
+            return make_token(TOKEN_MINUS, start, 1);
         case '*':
-            return create_token(TOKEN_MULTIPLY, "*", current_line, current_column);
+            return make_token(TOKEN_MULTIPLY, start, 1);
         case '/':
             if (lexer->current_char == '/')
             {
                 lexer_advance(lexer);
-                while (lexer->current_char != '\0' && lexer->current_char != '\n')
-                {
-                    lexer_advance(lexer);
-                }
+                lexer_skip(lexer, (int)scanner.line(lexer->source + lexer->position, lexer_remaining(lexer)));
                 if (lexer->current_char == '\n')
                 {
                     lexer_advance(lexer);
                 }
                 continue;
             }
-            return create_token(TOKEN_DIVIDE, "/", current_line, current_column);
+            return make_token(TOKEN_DIVIDE, start, 1);
         case '<':
-            return create_token(TOKEN_LESS, "<", current_line, current_column);
+            return make_token(TOKEN_LESS, start, 1);
         case '>':
-            return create_token(TOKEN_GREATER, ">", current_line, current_column);
+            return make_token(TOKEN_GREATER, start, 1);
         case '=':
-            return create_token(TOKEN_EQUALS, "=", current_line, current_column);
+            return make_token(TOKEN_EQUALS, start, 1);
         case ';':
-            return create_token(TOKEN_SEMICOLON, ";", current_line, current_column);
+            return make_token(TOKEN_SEMICOLON, start, 1);
         case '(':
-            return create_token(TOKEN_LPAREN, "(", current_line, current_column);
+            return make_token(TOKEN_LPAREN, start, 1);
         case ')':
-            return create_token(TOKEN_RPAREN, ")", current_line, current_column);
+            return make_token(TOKEN_RPAREN, start, 1);
         case '{':
-            return create_token(TOKEN_LBRACE, "{", current_line, current_column);
+            return make_token(TOKEN_LBRACE, start, 1);
         case '}':
-            return create_token(TOKEN_RBRACE, "}", current_line, current_column);
+            return make_token(TOKEN_RBRACE, start, 1);
         }
 
+        int line, column;
+        source_location(lexer->buffer, (uint32_t)start, &line, &column);
         printf("Error: Unknown character '%c' at line %d, column %d\n",
-               current, current_line, current_column);
+               current, line, column);
     }
 
-    return create_token(TOKEN_EOF, "", lexer->line, lexer->column);
+    return make_token(TOKEN_EOF, lexer->position, 0);
 }
 
-void free_lexer(Lexer *lexer)
+// Lex the whole source up front so the parser can walk a flat array
+TokenStream *create_token_stream(Lexer *lexer)
 {
-    if (lexer)
+    TokenStream *stream = (TokenStream *)region_alloc(REGION_TOKENS, sizeof(TokenStream));
+    stream->capacity = INITIAL_TOKEN_CAPACITY;
+    stream->count = 0;
+    stream->tokens = (Token *)region_alloc(REGION_TOKENS, stream->capacity * sizeof(Token));
+
+    Token token;
+    do
     {
-        free(lexer->source);
-        free(lexer);
+        token = lexer_get_next_token(lexer);
+        if (stream->count >= stream->capacity)
+        {
+            stream->tokens = (Token *)region_grow(REGION_TOKENS, stream->tokens,
+                                                  stream->capacity * sizeof(Token),
+                                                  stream->capacity * 2 * sizeof(Token));
+            stream->capacity *= 2;
+        }
+        stream->tokens[stream->count++] = token;
+    } while (token.type != TOKEN_EOF);
+
+    return stream;
+}
+
+// Text of a token's value; string literals are returned without their quotes
+const char *token_value(const Lexer *lexer, const Token *token, int *length)
+{
+    const char *text = lexer->source + token->offset;
+    int len = (int)token->length;
+
+    if (token->type == TOKEN_STRING_LITERAL && len > 0)
+    {
+        text++;
+        len--;
+        if (len > 0 && text[len - 1] == '"')
+            len--;
     }
+
+    *length = len;
+    return text;
+}
+
+int token_to_int(const Lexer *lexer, const Token *token)
+{
+    const char *text = lexer->source + token->offset;
+    int i = 0;
+    int negative = 0;
+    int value = 0;
+
+    if (token->length > 0 && text[0] == '-')
+    {
+        negative = 1;
+        i++;
+    }
+    for (; i < (int)token->length; i++)
+    {
+        value = value * 10 + (text[i] - '0');
+    }
+
+    return negative ? -value : value;
 }
\ No newline at end of file
@@ -0,0 +1,161 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../include/optimizer.h"
+#include "../include/cfg.h"
+
+// Loop-invariant code motion. A computation whose operands are constants,
+// variables the loop never assigns, or temps computed ahead of the loop (or
+// already hoisted) moves in front of the loop's header label. Only pure
+// instructions move: calls stay where they are, so show and ask keep their
+// order, and a division moves only when its divisor is a constant that cannot
+// trap. Pure instructions never fault, so hoisting one out of a loop that
+// runs zero times, or out of a branch, is safe.
+
+#define HOME_NONE (-1)    // temp never defined
+#define HOME_SEVERAL (-2) // temp defined more than once
+
+// A temp is invariant only when its one definition lies outside the loop and
+// runs before it: a temp whose definition a loop rewrite dropped, or one set
+// after the loop, must keep its uses where they are
+static bool is_invariant(const Cfg *cfg, Operand operand, const int *assigned, const int *defined, const int *home,
+                         int mark, int preheader)
+{
+    if (operand.kind == OPERAND_VAR)
+        return assigned[operand.id] != mark;
+    if (operand.kind == OPERAND_TEMP)
+        return defined[operand.id] != mark && home[operand.id] >= 0 && cfg_dominates(cfg, home[operand.id], preheader);
+    return true;
+}
+
+static void emit_copy(TacBuffer *tac, const TAC *code)
+{
+    TAC *copy = tac_emit(tac, code->op, code->result, code->arg1, code->arg2, code->offset);
+    copy->type = code->type;
+}
+
+int hoist_invariants(TacBuffer *tac, OptimizerStats *stats)
+{
+    if (tac->count == 0)
+        return 0;
+
+    Cfg *cfg = build_cfg(tac);
+    if (cfg->loop_count == 0)
+        return 0;
+
+    int count = tac->count;
+    int *assigned = (int *)region_calloc(REGION_IR, tac->slots->count + 1, sizeof(int));
+    int *defined = (int *)region_calloc(REGION_IR, tac->temp_count + 1, sizeof(int));
+    int *home = (int *)region_alloc(REGION_IR, (tac->temp_count + 1) * sizeof(int)); // block defining each temp
+    int *target = (int *)region_alloc(REGION_IR, (count + 1) * sizeof(int)); // header a hoisted instruction moves to
+    int *hoisted_at = (int *)region_calloc(REGION_IR, count + 1, sizeof(int));
+    int hoisted = 0;
+
+    for (uint32_t t = 0; t <= tac->temp_count; t++)
+        home[t] = HOME_NONE;
+    for (int i = 0; i < count; i++)
+    {
+        target[i] = -1;
+        Operand result = tac->code[i].result;
+        if (result.kind == OPERAND_TEMP)
+            home[result.id] = home[result.id] == HOME_NONE ? cfg->block_of[i] : HOME_SEVERAL;
+    }
+
+    // Innermost loops first; an instruction moves out of one loop per round,
+    // and the pipeline's next round can take it further out
+    for (int l = cfg->loop_count - 1; l >= 0; l--)
+    {
+        const Loop *loop = &cfg->loops[l];
+        int mark = l + 1;
+        int preheader = cfg_preheader(cfg, l);
+        if (preheader < 0)
+            continue;
+
+        for (int b = 0; b < loop->block_count; b++)
+        {
+            const BasicBlock *block = &cfg->blocks[loop->blocks[b]];
+            for (int i = block->first; i < block->last; i++)
+            {
+                const TAC *code = &tac->code[i];
+                if (code->result.kind == OPERAND_VAR)
+                    assigned[code->result.id] = mark;
+                else if (code->result.kind == OPERAND_TEMP)
+                    defined[code->result.id] = mark;
+            }
+        }
+
+        // Blocks are in code order and temps are defined before they are used,
+        // so one sweep sees every operand's verdict before its uses
+        for (int b = 0; b < loop->block_count; b++)
+        {
+            const BasicBlock *block = &cfg->blocks[loop->blocks[b]];
+            for (int i = block->first; i < block->last; i++)
+            {
+                const TAC *code = &tac->code[i];
+                if (target[i] >= 0 || code->op == TAC_ASSIGN || !tac_is_pure(code))
+                    continue;
+                if (code->arg1.kind == OPERAND_IMM && (code->arg2.kind == OPERAND_IMM || code->arg2.kind == OPERAND_NONE))
+                    continue;
+                if (!is_invariant(cfg, code->arg1, assigned, defined, home, mark, preheader) ||
+                    !is_invariant(cfg, code->arg2, assigned, defined, home, mark, preheader))
+                    continue;
+
+                target[i] = loop->header;
+                hoisted_at[loop->header]++;
+                hoisted++;
+                // It now runs in front of the header, at the end of the preheader
+                if (code->result.kind == OPERAND_TEMP)
+                {
+                    defined[code->result.id] = 0;
+                    if (home[code->result.id] != HOME_SEVERAL)
+                        home[code->result.id] = preheader;
+                }
+            }
+        }
+    }
+
+    if (hoisted == 0)
+        return 0;
+
+    // Re-emit the code with each loop's invariants in front of its header
+    TAC *old = (TAC *)region_alloc(REGION_IR, count * sizeof(TAC));
+    memcpy(old, tac->code, count * sizeof(TAC));
+    tac->count = 0;
+
+    for (int b = 0; b < cfg->block_count; b++)
+    {
+        const BasicBlock *block = &cfg->blocks[b];
+        if (hoisted_at[b] > 0)
+        {
+            for (int i = 0; i < count; i++)
+            {
+                if (target[i] != b)
+                    continue;
+                TAC moved = old[i];
+                if (moved.result.kind == OPERAND_VAR)
+                {
+                    // The variable is still assigned inside the loop, from a temp
+                    Operand temp = generate_temp_var(tac);
+                    TAC copy = old[i];
+                    copy.op = TAC_ASSIGN;
+                    copy.arg1 = temp;
+                    copy.arg2 = NO_OPERAND;
+                    old[i] = copy;
+                    moved.result = temp;
+                    moved.type = TYPE_NUM;
+                    target[i] = -2;
+                }
+                emit_copy(tac, &moved);
+            }
+        }
+
+        for (int i = block->first; i < block->last; i++)
+        {
+            if (target[i] < 0)
+                emit_copy(tac, &old[i]);
+        }
+    }
+
+    stats->hoisted += hoisted;
+    return hoisted;
+}
\ No newline at end of file
@@ -0,0 +1,68 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../include/liveness.h"
+
+int liveness_value(const TacBuffer *tac, Operand operand)
+{
+    if (operand.kind == OPERAND_TEMP)
+        return (int)operand.id;
+    if (operand.kind == OPERAND_VAR)
+        return (int)(tac->temp_count + operand.id);
+    return -1;
+}
+
+// Live-in sets grow until nothing changes, visiting blocks against the flow
+Liveness *compute_liveness(const Cfg *cfg)
+{
+    const TacBuffer *tac = cfg->tac;
+    Liveness *liveness = (Liveness *)region_alloc(REGION_IR, sizeof(Liveness));
+    liveness->cfg = cfg;
+    liveness->value_count = (int)(tac->temp_count + tac->slots->count);
+    liveness->words = (liveness->value_count + 63) / 64;
+
+    int words = liveness->words;
+    size_t set_count = (size_t)cfg->block_count * words + 1;
+    liveness->live_in = (uint64_t *)region_calloc(REGION_IR, set_count, sizeof(uint64_t));
+    liveness->live_out = (uint64_t *)region_calloc(REGION_IR, set_count, sizeof(uint64_t));
+    uint64_t *live = (uint64_t *)region_alloc(REGION_IR, (words + 1) * sizeof(uint64_t));
+
+    for (bool changed = true; changed;)
+    {
+        changed = false;
+        for (int b = cfg->block_count - 1; b >= 0; b--)
+        {
+            const BasicBlock *block = &cfg->blocks[b];
+            uint64_t *out = &liveness->live_out[b * words];
+            for (int s = 0; s < block->succ_count; s++)
+            {
+                for (int w = 0; w < words; w++)
+                    out[w] |= liveness->live_in[block->succs[s] * words + w];
+            }
+
+            memcpy(live, out, words * sizeof(uint64_t));
+            for (int i = block->last - 1; i >= block->first; i--)
+            {
+                const TAC *code = &tac->code[i];
+                int value = liveness_value(tac, code->result);
+                if (value >= 0)
+                    liveness_remove(live, value);
+                if ((value = liveness_value(tac, code->arg1)) >= 0)
+                    liveness_add(live, value);
+                if ((value = liveness_value(tac, code->arg2)) >= 0)
+                    liveness_add(live, value);
+            }
+
+            uint64_t *in = &liveness->live_in[b * words];
+            for (int w = 0; w < words; w++)
+            {
+                if (live[w] != in[w])
+                {
+                    in[w] = live[w];
+                    changed = true;
+                }
+            }
+        }
+    }
+    return liveness;
+}
\ No newline at end of file
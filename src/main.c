@@ -1,63 +1,66 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <errno.h>
+#include "../include/source.h"
 #include "../include/lexer.h"
 #include "../include/parser.h"
 #include "../include/semantic.h"
 #include "../include/tac.h"
+#include "../include/optimizer.h"
+#include "../include/cfg.h"
 #include "../include/gen.h"
+#include "../include/regalloc.h"
 
-void print_token(Token *token)
+void print_token(Lexer *lexer, Token *token)
 {
-    const char *type_names[] = {
-        "TOKEN_NUM", "TOKEN_STR",
-        "TOKEN_PLUS", "TOKEN_MINUS", "TOKEN_MULTIPLY", "TOKEN_DIVIDE",
-        "TOKEN_LESS", "TOKEN_GREATER",
-        "TOKEN_SHOW", "TOKEN_WHEN", "TOKEN_OTHERWISE", "TOKEN_REPEAT", "TOKEN_ASK",
-        "TOKEN_IDENTIFIER", "TOKEN_NUMBER_LITERAL", "TOKEN_STRING_LITERAL",
-        "TOKEN_EQUALS", "TOKEN_SEMICOLON",
-        "TOKEN_LPAREN", "TOKEN_RPAREN", "TOKEN_LBRACE", "TOKEN_RBRACE",
-        "TOKEN_EOF"};
-    printf("Token(type=%s, value='%s', line=%d, column=%d)\n",
-           type_names[token->type], token->value ? token->value : "", token->line, token->column);
+    int length, line, column;
+    const char *value = token_value(lexer, token, &length);
+    source_location(lexer->buffer, token->offset, &line, &column);
+    printf("Token(type=TOKEN_%s, value='%.*s', line=%d, column=%d)\n",
+           token_type_to_string(token->type), length, value, line, column);
 }
 
-void print_ast(Node *node, int indent)
+void print_ast(const Ast *ast, NodeId id, int indent)
 {
+    if (!id)
+        return;
+
+    const Node *node = ast_node(ast, id);
     for (int i = 0; i < indent; i++)
         printf("  ");
 
     switch (node->type)
     {
     case NODE_NUMBER:
-        printf("Number: %d\n", node->number.value);
+        printf("Number: %d\n", node->number);
         break;
 
     case NODE_STRING:
-        printf("String: \"%s\"\n", node->string.value);
+        printf("String: \"%s\"\n", name_str(node->string));
         break;
 
     case NODE_IDENTIFIER:
-        printf("Identifier: %s\n", node->identifier.name);
+        printf("Identifier: %s\n", name_str(node->identifier.name));
         break;
 
     case NODE_BINARY_OP:
-        printf("BinaryOp: %d\n", node->binary_op.op);
-        print_ast(node->binary_op.left, indent + 1);
-        print_ast(node->binary_op.right, indent + 1);
+        printf("BinaryOp: %d\n", node->op);
+        print_ast(ast, node->binary_op.left, indent + 1);
+        print_ast(ast, node->binary_op.right, indent + 1);
         break;
 
     case NODE_FUNCTION_CALL:
-        printf("FunctionCall: %s\n", node->function_call.name);
-        for (int i = 0; i < node->function_call.arg_count; i++)
+        printf("FunctionCall: %s\n", name_str(node->function_call.name));
+        for (uint32_t i = 0; i < node->function_call.arguments.count; i++)
         {
-            print_ast(node->function_call.arguments[i], indent + 1);
+            print_ast(ast, ast_child(ast, node->function_call.arguments, i), indent + 1);
         }
         break;
 
     case NODE_VARIABLE_DECLARATION:
-        printf("VarDecl: %s %s\n", node->var_decl.type, node->var_decl.name);
-        print_ast(node->var_decl.initializer, indent + 1);
+        printf("VarDecl: %s %s\n", name_str(node->var_decl.type), name_str(node->var_decl.name));
+        print_ast(ast, node->var_decl.initializer, indent + 1);
         break;
 
     case NODE_IF_STATEMENT:
@@ -65,17 +68,17 @@ void print_ast(Node *node, int indent)
         for (int i = 0; i < indent; i++)
             printf("  ");
         printf("Condition:\n");
-        print_ast(node->if_stmt.condition, indent + 1);
+        print_ast(ast, node->if_stmt.condition, indent + 1);
         for (int i = 0; i < indent; i++)
             printf("  ");
         printf("Then:\n");
-        print_ast(node->if_stmt.if_body, indent + 1);
+        print_ast(ast, node->if_stmt.if_body, indent + 1);
         if (node->if_stmt.else_body)
         {
             for (int i = 0; i < indent; i++)
                 printf("  ");
             printf("Else:\n");
-            print_ast(node->if_stmt.else_body, indent + 1);
+            print_ast(ast, node->if_stmt.else_body, indent + 1);
         }
         break;
 
@@ -84,113 +87,116 @@ void print_ast(Node *node, int indent)
         for (int i = 0; i < indent; i++)
             printf("  ");
         printf("Init:\n");
-        print_ast(node->for_loop.initializer, indent + 1);
+        print_ast(ast, node->for_loop.initializer, indent + 1);
         for (int i = 0; i < indent; i++)
             printf("  ");
         printf("Condition:\n");
-        print_ast(node->for_loop.condition, indent + 1);
+        print_ast(ast, node->for_loop.condition, indent + 1);
         for (int i = 0; i < indent; i++)
             printf("  ");
         printf("Increment:\n");
-        print_ast(node->for_loop.increment, indent + 1);
+        print_ast(ast, node->for_loop.increment, indent + 1);
         for (int i = 0; i < indent; i++)
             printf("  ");
         printf("Body:\n");
-        print_ast(node->for_loop.body, indent + 1);
+        print_ast(ast, node->for_loop.body, indent + 1);
         break;
 
     case NODE_BLOCK:
     case NODE_PROGRAM:
         printf("%s:\n", node->type == NODE_BLOCK ? "Block" : "Program");
-        for (int i = 0; i < node->block.count; i++)
+        for (uint32_t i = 0; i < node->block.count; i++)
         {
-            print_ast(node->block.statements[i], indent + 1);
+            print_ast(ast, ast_child(ast, node->block, i), indent + 1);
         }
         break;
     }
 }
 
-// FILE READ
-char *read_file(const char *filename)
+// Value of a numeric option, which must be a whole number from 0 to max
+static int parse_option_value(const char *option, const char *text, int max)
 {
-    FILE *file;
-    if (filename)
+    char *end;
+    errno = 0;
+    long value = strtol(text, &end, 10);
+    if (end == text || *end != '\0' || errno == ERANGE || value < 0 || value > max)
     {
-        file = fopen(filename, "r");
-        if (!file)
-        {
-            fprintf(stderr, "Error: Could not open file '%s'\n", filename);
-            exit(1);
-        }
-    }
-    else
-    {
-        file = stdin;
-    }
-
-    fseek(file, 0, SEEK_END);
-    long size = ftell(file);
-    fseek(file, 0, SEEK_SET);
-
-    char *buffer = (char *)malloc(size + 1);
-    if (!buffer)
-    {
-        fprintf(stderr, "Error: Could not allocate memory for file contents\n");
-        if (filename)
-            fclose(file);
+        fprintf(stderr, "Error: Invalid value '%s' for %s (expected 0 to %d)\n", text, option, max);
         exit(1);
     }
-    size_t read_size = fread(buffer, 1, size, file);
-    buffer[read_size] = '\0';
-
-    if (filename)
-        fclose(file);
-    return buffer;
+    return (int)value;
 }
 
 int main(int argc, char *argv[])
 {
-    char *source;
     const char *filename = NULL;
+    bool mem_stats = false;
+    OptimizerOptions options = {0, 0, DEFAULT_UNROLL_BUDGET};
+    bool dump_cfg = false;
+    int allocator = -1; // picked by -O level unless --regalloc names one
 
-    if (argc > 1)
+    for (int i = 1; i < argc; i++)
     {
-        filename = argv[1];
+        if (strcmp(argv[i], "--mem-stats") == 0)
+            mem_stats = true;
+        else if (strcmp(argv[i], "--dump-cfg") == 0)
+            dump_cfg = true;
+        else if (strncmp(argv[i], "-O", 2) == 0)
+            options.level = atoi(argv[i] + 2);
+        else if (strcmp(argv[i], "--unroll") == 0)
+            options.unroll_factor = DEFAULT_UNROLL_FACTOR;
+        else if (strncmp(argv[i], "--unroll=", 9) == 0)
+            options.unroll_factor = parse_option_value("--unroll", argv[i] + 9, MAX_UNROLL_FACTOR);
+        else if (strncmp(argv[i], "--unroll-budget=", 16) == 0)
+            options.unroll_budget = parse_option_value("--unroll-budget", argv[i] + 16, MAX_UNROLL_BUDGET);
+        else if (strcmp(argv[i], "--regalloc=linear") == 0)
+            allocator = REGALLOC_LINEAR;
+        else if (strcmp(argv[i], "--regalloc=coloring") == 0)
+            allocator = REGALLOC_COLORING;
+        else if (strncmp(argv[i], "--regalloc=", 11) == 0)
+        {
+            fprintf(stderr, "Error: Unknown register allocator '%s' (expected linear or coloring)\n", argv[i] + 11);
+            exit(1);
+        }
+        else
+            filename = argv[i];
     }
 
-    source = read_file(filename);
+    SourceBuffer *source = source_open(filename);
+    if (!source)
+    {
+        if (filename)
+            fprintf(stderr, "Error: Could not open file '%s'\n", filename);
+        else
+            fprintf(stderr, "Error: Could not read program from standard input\n");
+        exit(1);
+    }
 
     if (filename)
     {
         printf("Processing file: %s\n\n", filename);
     }
-    printf("Source code:\n%s\n", source);
+    printf("Source code:\n%.*s\n", (int)source->length, source->text);
 
     printf("\nTokens:\n");
     Lexer *lexer = create_lexer(source);
-    Token *token;
-    TokenType type;
+    Parser *parser = create_parser(lexer);
 
-    do
+    for (int i = 0; i < parser->tokens->count; i++)
     {
-        token = lexer_get_next_token(lexer);
-        type = token->type;
-        print_token(token);
-        free(token->value);
-        free(token);
-    } while (type != TOKEN_EOF);
-
-    free_lexer(lexer);
-    lexer = create_lexer(source);
-    Parser *parser = create_parser(lexer);
+        print_token(lexer, &parser->tokens->tokens[i]);
+    }
 
     printf("\nParsing.....\n");
-    Node *ast = parse_program(parser);
+    Ast *ast = parse_program(parser);
+
+    // Nodes carry source offsets, so the tokens are dead once the tree exists
+    region_release(REGION_TOKENS);
 
     if (ast != NULL)
     {
         printf("\nAbstract Syntax Tree:\n");
-        print_ast(ast, 0);
+        print_ast(ast, ast->root, 0);
 
         printf("\nPerforming semantic analysis.....\n");
         SemanticContext *context = create_semantic_context();
@@ -202,52 +208,87 @@ int main(int argc, char *argv[])
             for (int i = 0; i < context->error_count; i++)
             {
                 SemanticError *error = &context->errors[i];
+                int line, column;
+                source_location(source, error->offset, &line, &column);
                 printf("Error at line %d, column %d: %s - %s\n",
-                       error->line, error->column,
+                       line, column,
                        get_error_type_string(error->type),
                        error->message);
             }
         }
-        else
+        region_release(REGION_SYMBOLS);
+
+        if (success)
         {
             printf("\nNo semantic errors found.\n");
             printf("\nGenerating Three-Address Code.....\n");
-            TAC *tac = ast_to_tac(ast);
-            if (tac)
+            TacBuffer *tac = ast_to_tac(ast);
+            region_release(REGION_AST);
+            if (tac && tac->count > 0)
             {
                 printf("\nGenerated Three-Address Code:\n");
                 printf("----------------------------\n");
                 print_tac_list(tac);
+                if (options.level > 0)
+                {
+                    OptimizerStats stats;
+                    optimize_tac(tac, &options, &stats);
+                    printf("\nOptimized Three-Address Code (-O%d):\n", options.level);
+                    printf("----------------------------\n");
+                    print_tac_list(tac);
+                    print_optimizer_stats(&stats);
+                }
+                if (dump_cfg)
+                {
+                    Cfg *cfg = build_cfg(tac);
+                    FILE *dot = fopen("cfg.dot", "w");
+                    if (dot)
+                    {
+                        write_cfg_dot(cfg, dot);
+                        fclose(dot);
+                        printf("\nControl flow graph (%d blocks, %d loops) written to cfg.dot\n",
+                               cfg->block_count, cfg->loop_count);
+                    }
+                    else
+                    {
+                        printf("Error: Could not write to cfg.dot\n");
+                    }
+                }
+                // Without optimization every value keeps its memory home
+                RegisterAllocation *allocation;
+                if (options.level == 0)
+                {
+                    allocation = allocate_stack_frame(tac);
+                }
+                else
+                {
+                    if (allocator < 0)
+                        allocator = options.level >= 2 ? REGALLOC_COLORING : REGALLOC_LINEAR;
+                    if (allocator == REGALLOC_COLORING)
+                        allocation = allocate_graph_coloring(tac);
+                    else
+                        allocation = allocate_linear_scan(tac);
+                    printf("\nRegister allocation (%s): %d values in registers, %d spilled, %d copies coalesced\n",
+                           allocator == REGALLOC_COLORING ? "graph coloring" : "linear scan", allocation->allocated,
+                           allocation->spilled, allocation->coalesced);
+                }
+                printf("Stack frame: %d slots (%d bytes), %d values in .bss\n", allocation->frame_slots,
+                       allocation->frame_slots * 8, allocation->globals);
                 printf("\nGenerating Assembly Code.....\n");
-                char *assembly = generate_code(tac);
+                char *assembly = generate_code(tac, allocation);
+                region_release(REGION_IR);
                 if (assembly)
                 {
                     const char *prefix = "default rel\n\n";
-                    size_t prefix_len = strlen(prefix);
-                    size_t assembly_len = strlen(assembly);
-                    char *new_assembly = malloc(prefix_len + assembly_len + 1);
-                    if (!new_assembly)
-                    {
-                        printf("Error: Memory allocation failed\n");
-                        free(assembly);
-                        tac_free(tac);
-                        free_semantic_context(context);
-                        free_node(ast);
-                        free_parser(parser);
-                        free_lexer(lexer);
-                        free(source);
-                        return 1;
-                    }
-                    memcpy(new_assembly, prefix, prefix_len);
-                    memcpy(new_assembly + prefix_len, assembly, assembly_len + 1);
 
                     printf("\nGenerated Assembly Code:\n");
                     printf("----------------------------\n");
-                    printf("%s\n", new_assembly);
+                    printf("%s%s\n", prefix, assembly);
                     FILE *fout = fopen("x86_64.asm", "w");
                     if (fout)
                     {
-                        fputs(new_assembly, fout);
+                        fputs(prefix, fout);
+                        fputs(assembly, fout);
                         fclose(fout);
                         printf("Assembly code written to x86_64.asm\n");
                     }
@@ -255,35 +296,33 @@ int main(int argc, char *argv[])
                     {
                         printf("Error: Could not write to x86_64.asm\n");
                     }
-
-                    free(new_assembly);
-                    free(assembly);
                 }
 
                 else
                 {
                     printf("Error: Failed to generate assembly code\n");
                 }
-
-                tac_free(tac);
             }
             else
             {
                 printf("Error: Failed to generate TAC\n");
             }
         }
-
-        free_semantic_context(context);
-        free_node(ast);
     }
     else
     {
         printf("\nError: Failed to parse the program\n");
     }
 
-    free_parser(parser);
-    free_lexer(lexer);
-    free(source);
+    region_release_all();
+    if (mem_stats)
+    {
+        printf("\nCompiler memory by region (bytes):\n");
+        region_report(stdout);
+    }
+
+    intern_free();
+    source_close(source);
 
     return 0;
 }
\ No newline at end of file
@@ -1 +1,507 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../include/optimizer.h"
+#include "../include/liveness.h"
 
+#define MAX_ROUNDS 8
+
+typedef int (*PassFunction)(TacBuffer *tac, OptimizerStats *stats);
+
+// A pass returns how many instructions it changed; the pipeline reruns until
+// a round changes nothing
+typedef struct
+{
+    const char *name;
+    int level; // lowest -O level that runs the pass
+    PassFunction run;
+} OptimizerPass;
+
+bool tac_is_binary(TACOpType op)
+{
+    switch (op)
+    {
+    case TAC_ADD:
+    case TAC_SUB:
+    case TAC_MUL:
+    case TAC_DIV:
+    case TAC_MOD:
+    case TAC_LESS:
+    case TAC_LESS_EQ:
+    case TAC_GREATER:
+    case TAC_GREATER_EQ:
+    case TAC_EQ:
+    case TAC_NEQ:
+        return true;
+    default:
+        return false;
+    }
+}
+
+// Whether the instruction only computes its result: no call, no jump, and no
+// division that could trap at run time
+bool tac_is_pure(const TAC *tac)
+{
+    if (tac->op == TAC_DIV || tac->op == TAC_MOD)
+        return tac->arg2.kind == OPERAND_IMM && tac->arg2.imm != 0 && tac->arg2.imm != -1;
+    return tac->op == TAC_ASSIGN || tac->op == TAC_NEG || tac_is_binary(tac->op);
+}
+
+// v = v + c, v = c + v or v = v - c with a nonzero constant c; the step is
+// returned with its sign
+bool tac_induction_step(const TAC *tac, int64_t *step)
+{
+    Operand var = tac->result;
+    if (var.kind != OPERAND_VAR)
+        return false;
+    if (tac->op == TAC_ADD && operand_equal(tac->arg1, var) && tac->arg2.kind == OPERAND_IMM)
+        *step = tac->arg2.imm;
+    else if (tac->op == TAC_ADD && operand_equal(tac->arg2, var) && tac->arg1.kind == OPERAND_IMM)
+        *step = tac->arg1.imm;
+    else if (tac->op == TAC_SUB && operand_equal(tac->arg1, var) && tac->arg2.kind == OPERAND_IMM &&
+             tac->arg2.imm != INT64_MIN)
+        *step = -tac->arg2.imm;
+    else
+        return false;
+    return *step != 0;
+}
+
+// The constant the last assignment to var in code[first, last) stores, if any
+bool tac_constant_before(const TacBuffer *tac, int first, int last, SlotId var, int64_t *value)
+{
+    for (int i = last - 1; i >= first; i--)
+    {
+        const TAC *code = &tac->code[i];
+        if (code->result.kind == OPERAND_VAR && code->result.id == var)
+        {
+            if (code->op != TAC_ASSIGN || code->arg1.kind != OPERAND_IMM)
+                return false;
+            *value = code->arg1.imm;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Arithmetic wraps like the 64-bit machine instructions; a division that would
+// trap is left for run time
+bool tac_evaluate(TACOpType op, int64_t a, int64_t b, int64_t *value)
+{
+    uint64_t ua = (uint64_t)a;
+    uint64_t ub = (uint64_t)b;
+    switch (op)
+    {
+    case TAC_ADD:
+        *value = (int64_t)(ua + ub);
+        return true;
+    case TAC_SUB:
+        *value = (int64_t)(ua - ub);
+        return true;
+    case TAC_MUL:
+        *value = (int64_t)(ua * ub);
+        return true;
+    case TAC_DIV:
+    case TAC_MOD:
+        if (b == 0 || (a == INT64_MIN && b == -1))
+            return false;
+        *value = op == TAC_DIV ? a / b : a % b;
+        return true;
+    case TAC_LESS:
+        *value = a < b;
+        return true;
+    case TAC_LESS_EQ:
+        *value = a <= b;
+        return true;
+    case TAC_GREATER:
+        *value = a > b;
+        return true;
+    case TAC_GREATER_EQ:
+        *value = a >= b;
+        return true;
+    case TAC_EQ:
+        *value = a == b;
+        return true;
+    case TAC_NEQ:
+        *value = a != b;
+        return true;
+    default:
+        return false;
+    }
+}
+
+static bool substitute(Operand *operand, const Operand *temp_value, const Operand *var_value)
+{
+    Operand value = NO_OPERAND;
+    if (operand->kind == OPERAND_TEMP)
+        value = temp_value[operand->id];
+    else if (operand->kind == OPERAND_VAR)
+        value = var_value[operand->id];
+
+    if (value.kind == OPERAND_NONE)
+        return false;
+    *operand = value;
+    return true;
+}
+
+// Forward walk over the code. Temps are assigned exactly once, before every use,
+// so a temp's value holds everywhere. Copies of variables and the constants known
+// for variables only hold until the variable is written or a label is reached.
+static int propagate_and_fold(TacBuffer *tac, OptimizerStats *stats)
+{
+    uint32_t var_count = tac->slots->count;
+    Operand *temp_value = (Operand *)region_calloc(REGION_IR, tac->temp_count + 1, sizeof(Operand));
+    Operand *var_value = (Operand *)region_calloc(REGION_IR, var_count, sizeof(Operand));
+    uint32_t *copies = (uint32_t *)region_alloc(REGION_IR, (tac->temp_count + 1) * sizeof(uint32_t));
+    SlotId *known = (SlotId *)region_alloc(REGION_IR, var_count * sizeof(SlotId));
+    int copy_count = 0;
+    int known_count = 0;
+    int changes = 0;
+
+    for (int i = 0; i < tac->count; i++)
+    {
+        TAC *current = &tac->code[i];
+
+        if (current->op == TAC_LABEL)
+        {
+            for (int j = 0; j < copy_count; j++)
+                temp_value[copies[j]] = NO_OPERAND;
+            for (int j = 0; j < known_count; j++)
+                var_value[known[j]] = NO_OPERAND;
+            copy_count = 0;
+            known_count = 0;
+            continue;
+        }
+
+        // The callee in arg1 of a call is not a value
+        if (current->op != TAC_CALL && substitute(&current->arg1, temp_value, var_value))
+        {
+            stats->propagated++;
+            changes++;
+        }
+        if (substitute(&current->arg2, temp_value, var_value))
+        {
+            stats->propagated++;
+            changes++;
+        }
+
+        int64_t value;
+        if (tac_is_binary(current->op) && current->arg1.kind == OPERAND_IMM && current->arg2.kind == OPERAND_IMM &&
+            tac_evaluate(current->op, current->arg1.imm, current->arg2.imm, &value))
+        {
+            current->op = TAC_ASSIGN;
+            current->arg1 = make_imm(value);
+            current->arg2 = NO_OPERAND;
+            stats->folded++;
+            changes++;
+        }
+        else if (current->op == TAC_NEG && current->arg1.kind == OPERAND_IMM)
+        {
+            current->op = TAC_ASSIGN;
+            current->arg1 = make_imm((int64_t)(0 - (uint64_t)current->arg1.imm));
+            stats->folded++;
+            changes++;
+        }
+        else if (current->op == TAC_IF && current->arg1.kind == OPERAND_IMM)
+        {
+            // A branch on a constant either always jumps or never does
+            current->op = current->arg1.imm != 0 ? TAC_GOTO : TAC_NOP;
+            current->arg1 = NO_OPERAND;
+            stats->folded++;
+            changes++;
+            continue;
+        }
+
+        if (current->result.kind == OPERAND_TEMP)
+        {
+            if (current->op == TAC_ASSIGN)
+            {
+                temp_value[current->result.id] = current->arg1;
+                if (current->arg1.kind == OPERAND_VAR)
+                    copies[copy_count++] = current->result.id;
+            }
+        }
+        else if (current->result.kind == OPERAND_VAR)
+        {
+            SlotId var = current->result.id;
+            for (int j = 0; j < copy_count; j++)
+            {
+                if (temp_value[copies[j]].kind == OPERAND_VAR && temp_value[copies[j]].id == var)
+                    temp_value[copies[j]] = NO_OPERAND;
+            }
+
+            bool constant = current->op == TAC_ASSIGN &&
+                            (current->arg1.kind == OPERAND_IMM || current->arg1.kind == OPERAND_STRING);
+            if (constant && var_value[var].kind == OPERAND_NONE)
+                known[known_count++] = var;
+            var_value[var] = constant ? current->arg1 : NO_OPERAND;
+        }
+    }
+
+    return changes;
+}
+
+// Position of every label, or -1 for labels no longer in the code
+static int *find_labels(const TacBuffer *tac)
+{
+    int *label_at = (int *)region_alloc(REGION_IR, (tac->label_count + 1) * sizeof(int));
+    for (uint32_t i = 0; i < tac->label_count; i++)
+        label_at[i] = -1;
+    for (int i = 0; i < tac->count; i++)
+    {
+        if (tac->code[i].op == TAC_LABEL)
+            label_at[tac->code[i].result.id] = i;
+    }
+    return label_at;
+}
+
+// Drops code that no path from the entry reaches, labels nothing jumps to, and
+// jumps to the very next instruction
+static int remove_unreachable(TacBuffer *tac, OptimizerStats *stats)
+{
+    if (tac->count == 0)
+        return 0;
+
+    int *label_at = find_labels(tac);
+    bool *reached = (bool *)region_calloc(REGION_IR, tac->count, sizeof(bool));
+    int *stack = (int *)region_alloc(REGION_IR, (tac->count + 1) * sizeof(int));
+    int top = 0;
+    int changes = 0;
+
+    stack[top++] = 0;
+    while (top > 0)
+    {
+        int i = stack[--top];
+        while (i >= 0 && i < tac->count && !reached[i])
+        {
+            const TAC *current = &tac->code[i];
+            reached[i] = true;
+            if (current->op == TAC_GOTO)
+            {
+                i = label_at[current->result.id];
+                continue;
+            }
+            if (current->op == TAC_IF)
+                stack[top++] = label_at[current->result.id];
+            i++;
+        }
+    }
+
+    int *references = (int *)region_calloc(REGION_IR, tac->label_count + 1, sizeof(int));
+    for (int i = 0; i < tac->count; i++)
+    {
+        TAC *current = &tac->code[i];
+        if (!reached[i] && current->op != TAC_NOP)
+        {
+            current->op = TAC_NOP;
+            stats->unreachable++;
+            changes++;
+        }
+        else if (current->op == TAC_IF || current->op == TAC_GOTO)
+        {
+            references[current->result.id]++;
+        }
+    }
+
+    int previous_jump = -1;
+    for (int i = 0; i < tac->count; i++)
+    {
+        TAC *current = &tac->code[i];
+        if (current->op == TAC_NOP)
+            continue;
+
+        if (current->op == TAC_LABEL && previous_jump >= 0 &&
+            tac->code[previous_jump].result.id == current->result.id)
+        {
+            tac->code[previous_jump].op = TAC_NOP;
+            references[current->result.id]--;
+            changes++;
+        }
+        if (current->op == TAC_LABEL && references[current->result.id] == 0)
+        {
+            current->op = TAC_NOP;
+            changes++;
+            continue;
+        }
+        previous_jump = current->op == TAC_GOTO ? i : -1;
+    }
+
+    return changes;
+}
+
+static void count_use(int *uses, Operand operand, int delta)
+{
+    if (operand.kind == OPERAND_TEMP)
+        uses[operand.id] += delta;
+}
+
+// Removes pure instructions whose temp is never read, then folds a temp that is
+// only copied into a variable by the next instruction: t = x + 1; x = t becomes
+// x = x + 1
+static int remove_dead_temps(TacBuffer *tac, OptimizerStats *stats)
+{
+    int *uses = (int *)region_calloc(REGION_IR, tac->temp_count + 1, sizeof(int));
+    int changes = 0;
+
+    for (int i = 0; i < tac->count; i++)
+    {
+        if (tac->code[i].op == TAC_NOP)
+            continue;
+        count_use(uses, tac->code[i].arg1, 1);
+        count_use(uses, tac->code[i].arg2, 1);
+    }
+
+    // Uses follow definitions, so one backward sweep also frees whole chains
+    for (int i = tac->count - 1; i >= 0; i--)
+    {
+        TAC *current = &tac->code[i];
+        if (current->result.kind == OPERAND_TEMP && uses[current->result.id] == 0 && tac_is_pure(current))
+        {
+            count_use(uses, current->arg1, -1);
+            count_use(uses, current->arg2, -1);
+            current->op = TAC_NOP;
+            stats->dead++;
+            changes++;
+        }
+    }
+
+    int previous = -1;
+    for (int i = 0; i < tac->count; i++)
+    {
+        TAC *current = &tac->code[i];
+        if (current->op == TAC_NOP)
+            continue;
+
+        if (current->op == TAC_ASSIGN && current->result.kind == OPERAND_VAR &&
+            current->arg1.kind == OPERAND_TEMP && uses[current->arg1.id] == 1 && previous >= 0)
+        {
+            TAC *definition = &tac->code[previous];
+            if (tac_is_pure(definition) && operand_equal(definition->result, current->arg1))
+            {
+                definition->result = current->result;
+                definition->type = current->type;
+                current->op = TAC_NOP;
+                stats->propagated++;
+                changes++;
+                continue;
+            }
+        }
+        previous = i;
+    }
+
+    return changes;
+}
+
+// Variable stores nothing reads before the next store or the end of the
+// program, found with liveness over the control flow graph
+static int remove_dead_stores(TacBuffer *tac, OptimizerStats *stats)
+{
+    if (tac->count == 0)
+        return 0;
+
+    Cfg *cfg = build_cfg(tac);
+    Liveness *liveness = compute_liveness(cfg);
+    int words = liveness->words;
+    uint64_t *live = (uint64_t *)region_alloc(REGION_IR, (words + 1) * sizeof(uint64_t));
+    int changes = 0;
+
+    for (int b = 0; b < cfg->block_count; b++)
+    {
+        const BasicBlock *block = &cfg->blocks[b];
+        memcpy(live, &liveness->live_out[b * words], words * sizeof(uint64_t));
+        for (int i = block->last - 1; i >= block->first; i--)
+        {
+            TAC *code = &tac->code[i];
+            int value = liveness_value(tac, code->result);
+            if (code->result.kind == OPERAND_VAR)
+            {
+                if (!liveness_contains(live, value) && tac_is_pure(code))
+                {
+                    code->op = TAC_NOP;
+                    stats->dead++;
+                    changes++;
+                    continue;
+                }
+                liveness_remove(live, value);
+            }
+            if ((value = liveness_value(tac, code->arg1)) >= 0)
+                liveness_add(live, value);
+            if ((value = liveness_value(tac, code->arg2)) >= 0)
+                liveness_add(live, value);
+        }
+    }
+    return changes;
+}
+
+static void compact(TacBuffer *tac)
+{
+    int count = 0;
+    for (int i = 0; i < tac->count; i++)
+    {
+        if (tac->code[i].op != TAC_NOP)
+            tac->code[count++] = tac->code[i];
+    }
+    tac->count = count;
+}
+
+static const OptimizerPass passes[] = {
+    {"sccp", 1, propagate_constants},
+    {"gvn", 1, number_values},
+    {"propagate", 1, propagate_and_fold},
+    {"unreachable", 1, remove_unreachable},
+    {"dead", 1, remove_dead_temps},
+    {"stores", 1, remove_dead_stores},
+    {"licm", 1, hoist_invariants},
+    {"induction", 1, reduce_induction},
+};
+
+// Runs every pass enabled at this level until a round changes nothing
+static void run_passes(TacBuffer *tac, int level, OptimizerStats *stats)
+{
+    for (int round = 0; round < MAX_ROUNDS; round++)
+    {
+        int changes = 0;
+        for (size_t i = 0; i < sizeof(passes) / sizeof(passes[0]); i++)
+        {
+            if (passes[i].level <= level)
+            {
+                changes += passes[i].run(tac, stats);
+                compact(tac);
+            }
+        }
+        if (changes == 0)
+            break;
+    }
+}
+
+void optimize_tac(TacBuffer *tac, const OptimizerOptions *options, OptimizerStats *stats)
+{
+    memset(stats, 0, sizeof(OptimizerStats));
+    stats->before = tac->count;
+
+    if (options->level > 0)
+    {
+        run_passes(tac, options->level, stats);
+        // Unrolling copies code the passes have already simplified, and leaves
+        // constant tests and dead labels for them to fold
+        if (options->unroll_factor > 0 && unroll_loops(tac, options, stats) > 0)
+        {
+            compact(tac);
+            run_passes(tac, options->level, stats);
+        }
+        // Last, since the loop passes look for the test at the top; the guard
+        // it copies in front of a loop often folds away
+        if (rotate_loops(tac, stats) > 0)
+            run_passes(tac, options->level, stats);
+    }
+
+    stats->after = tac->count;
+}
+
+void print_optimizer_stats(const OptimizerStats *stats)
+{
+    printf("Instructions: %d -> %d (folded %d, propagated %d, unreachable %d, dead %d, hoisted %d, "
+           "reduced %d, eliminated %d, unrolled %d, redundant %d, rotated %d)\n",
+           stats->before, stats->after, stats->folded, stats->propagated,
+           stats->unreachable, stats->dead, stats->hoisted, stats->reduced, stats->eliminated,
+           stats->unrolled, stats->redundant, stats->rotated);
+}
\ No newline at end of file
@@ -3,72 +3,28 @@
 #include <string.h>
 #include "../include/parser.h"
 
-const char *token_type_to_string(TokenType type)
-{
-    switch (type)
-    {
-    case TOKEN_NUM:
-        return "NUM";
-    case TOKEN_STR:
-        return "STR";
-    case TOKEN_PLUS:
-        return "PLUS";
-    case TOKEN_MINUS:
-        return "MINUS";
-    case TOKEN_MULTIPLY:
-        return "MULTIPLY";
-    case TOKEN_DIVIDE:
-        return "DIVIDE";
-    case TOKEN_LESS:
-        return "LESS";
-    case TOKEN_GREATER:
-        return "GREATER";
-    case TOKEN_SHOW:
-        return "SHOW";
-    case TOKEN_WHEN:
-        return "WHEN";
-    case TOKEN_OTHERWISE:
-        return "OTHERWISE";
-    case TOKEN_REPEAT:
-        return "REPEAT";
-    case TOKEN_ASK:
-        return "ASK";
-    case TOKEN_IDENTIFIER:
-        return "IDENTIFIER";
-    case TOKEN_NUMBER_LITERAL:
-        return "NUMBER_LITERAL";
-    case TOKEN_STRING_LITERAL:
-        return "STRING_LITERAL";
-    case TOKEN_EQUALS:
-        return "EQUALS";
-    case TOKEN_SEMICOLON:
-        return "SEMICOLON";
-    case TOKEN_LPAREN:
-        return "LPAREN";
-    case TOKEN_RPAREN:
-        return "RPAREN";
-    case TOKEN_LBRACE:
-        return "LBRACE";
-    case TOKEN_RBRACE:
-        return "RBRACE";
-    case TOKEN_EOF:
-        return "EOF";
-    default:
-        return "UNKNOWN";
-    }
-}
-
 Parser *create_parser(Lexer *lexer)
 {
-    Parser *parser = (Parser *)malloc(sizeof(Parser));
+    Parser *parser = (Parser *)region_alloc(REGION_TOKENS, sizeof(Parser));
     parser->lexer = lexer;
-    parser->current_token = lexer_get_next_token(lexer);
+    parser->tokens = create_token_stream(lexer);
+    parser->position = 0;
+    parser->current_token = &parser->tokens->tokens[0];
+    parser->ast = NULL;
+    parser->scratch = NULL;
+    parser->scratch_count = 0;
+    parser->scratch_capacity = 0;
     return parser;
 }
 
 void parser_advance(Parser *parser)
 {
-    parser->current_token = lexer_get_next_token(parser->lexer);
+    // The stream always ends with TOKEN_EOF, which is never stepped past
+    if (parser->current_token->type != TOKEN_EOF)
+    {
+        parser->position++;
+        parser->current_token = &parser->tokens->tokens[parser->position];
+    }
 }
 
 bool parser_expect(Parser *parser, TokenType type)
@@ -80,25 +36,41 @@ bool parser_expect(Parser *parser, TokenType type)
     }
     else
     {
-        fprintf(stderr, "Error: Expected %s but got '%s' (%s) at line %d, column %d\n",
+        int length, line, column;
+        const char *value = token_value(parser->lexer, parser->current_token, &length);
+        source_location(parser->lexer->buffer, parser->current_token->offset, &line, &column);
+        fprintf(stderr, "Error: Expected %s but got '%.*s' (%s) at line %d, column %d\n",
                 token_type_to_string(type),
-                parser->current_token->value ? parser->current_token->value : "EOF",
+                length, value,
                 token_type_to_string(parser->current_token->type),
-                parser->current_token->line,
-                parser->current_token->column);
+                line, column);
         return false;
     }
 }
 
-void free_parser(Parser *parser)
+// Identifier-like tokens are interned straight from the source span
+static NameId parser_intern(Parser *parser, const Token *token)
 {
-    free(parser->current_token);
-    free(parser);
+    return intern(parser->lexer->source + token->offset, (int)token->length);
+}
+
+// Park a finished statement until its enclosing block is complete
+static void parser_push_statement(Parser *parser, NodeId stmt)
+{
+    if (parser->scratch_count >= parser->scratch_capacity)
+    {
+        int capacity = parser->scratch_capacity == 0 ? 64 : parser->scratch_capacity * 2;
+        parser->scratch = (NodeId *)region_grow(REGION_TOKENS, parser->scratch,
+                                                parser->scratch_capacity * sizeof(NodeId),
+                                                capacity * sizeof(NodeId));
+        parser->scratch_capacity = capacity;
+    }
+    parser->scratch[parser->scratch_count++] = stmt;
 }
 
 // Forward declarations for recursive descent
-static Node *parse_block(Parser *parser);
-Node *parse_primary(Parser *parser)
+static NodeId parse_block(Parser *parser);
+NodeId parse_primary(Parser *parser)
 {
     Token *token = parser->current_token;
 
@@ -106,11 +78,15 @@ Node *parse_primary(Parser *parser)
     {
     case TOKEN_NUMBER_LITERAL:
         parser_advance(parser);
-        return create_number_node(atoi(token->value), token->line, token->column);
+        return create_number_node(parser->ast, token_to_int(parser->lexer, token), token->offset);
 
     case TOKEN_STRING_LITERAL:
+    {
+        int length;
+        const char *value = token_value(parser->lexer, token, &length);
         parser_advance(parser);
-        return create_string_node(token->value, token->line, token->column);
+        return create_string_node(parser->ast, intern(value, length), token->offset);
+    }
 
     case TOKEN_IDENTIFIER:
         parser_advance(parser);
@@ -118,7 +94,7 @@ Node *parse_primary(Parser *parser)
         {
             return parse_function_call(parser, token);
         }
-        return create_identifier_node(token->value, token->line, token->column);
+        return create_identifier_node(parser->ast, parser_intern(parser, token), token->offset);
 
     case TOKEN_SHOW:
     case TOKEN_ASK:
@@ -126,33 +102,30 @@ Node *parse_primary(Parser *parser)
 
     case TOKEN_LPAREN:
         parser_advance(parser);
-        Node *expr = parse_expression(parser);
+        NodeId expr = parse_expression(parser);
         if (!expr)
-            return NULL;
+            return NODE_NONE;
         if (!parser_expect(parser, TOKEN_RPAREN))
-        {
-            free_node(expr);
-            return NULL;
-        }
+            return NODE_NONE;
         return expr;
 
     default:
-        return NULL;
+        return NODE_NONE;
     }
 }
 
 // Parse a factor (unary operations and primary expressions)
-Node *parse_factor(Parser *parser)
+NodeId parse_factor(Parser *parser)
 {
     return parse_primary(parser);
 }
 
 // Parse a term (multiplication and division)
-Node *parse_term(Parser *parser)
+NodeId parse_term(Parser *parser)
 {
-    Node *left = parse_primary(parser);
+    NodeId left = parse_primary(parser);
     if (!left)
-        return NULL;
+        return NODE_NONE;
 
     while (parser->current_token->type == TOKEN_MULTIPLY ||
            parser->current_token->type == TOKEN_DIVIDE)
@@ -161,22 +134,22 @@ Node *parse_term(Parser *parser)
         BinaryOpType op = (op_token->type == TOKEN_MULTIPLY) ? OP_MULTIPLY : OP_DIVIDE;
         parser_advance(parser);
 
-        Node *right = parse_primary(parser);
+        NodeId right = parse_primary(parser);
         if (!right)
-            return NULL;
+            return NODE_NONE;
 
-        left = create_binary_op_node(op, left, right, op_token->line, op_token->column);
+        left = create_binary_op_node(parser->ast, op, left, right, op_token->offset);
     }
 
     return left;
 }
 
 // Parse an expression (addition, subtraction, comparison)
-Node *parse_expression(Parser *parser)
+NodeId parse_expression(Parser *parser)
 {
-    Node *left = parse_term(parser);
+    NodeId left = parse_term(parser);
     if (!left)
-        return NULL;
+        return NODE_NONE;
 
     while (parser->current_token->type == TOKEN_PLUS ||
            parser->current_token->type == TOKEN_MINUS ||
@@ -200,124 +173,113 @@ Node *parse_expression(Parser *parser)
             op = OP_GREATER;
             break;
         default:
-            return NULL;
+            return NODE_NONE;
         }
         parser_advance(parser);
 
-        Node *right = parse_term(parser);
+        NodeId right = parse_term(parser);
         if (!right)
-            return NULL;
+            return NODE_NONE;
 
-        left = create_binary_op_node(op, left, right, op_token->line, op_token->column);
+        left = create_binary_op_node(parser->ast, op, left, right, op_token->offset);
     }
 
     return left;
 }
 
 // Parse a block of statements
-static Node *parse_block(Parser *parser)
+static NodeId parse_block(Parser *parser)
 {
     Token *start_token = parser->current_token;
     if (!parser_expect(parser, TOKEN_LBRACE))
-        return NULL;
-
-    Node **statements = NULL;
-    int count = 0;
-    int capacity = 0;
+        return NODE_NONE;
 
+    int mark = parser->scratch_count;
     while (parser->current_token->type != TOKEN_RBRACE)
     {
-        if (count >= capacity)
-        {
-            capacity = capacity == 0 ? 4 : capacity * 2;
-            statements = realloc(statements, capacity * sizeof(Node *));
-        }
-
-        Node *stmt = parse_statement(parser);
+        NodeId stmt = parse_statement(parser);
         if (!stmt)
         {
-            free(statements);
-            return NULL;
+            parser->scratch_count = mark;
+            return NODE_NONE;
         }
-
-        statements[count++] = stmt;
+        parser_push_statement(parser, stmt);
     }
 
+    int count = parser->scratch_count - mark;
+    parser->scratch_count = mark;
     if (!parser_expect(parser, TOKEN_RBRACE))
-    {
-        free(statements);
-        return NULL;
-    }
+        return NODE_NONE;
 
-    return create_block_node(statements, count, start_token->line, start_token->column);
+    return create_block_node(parser->ast, parser->scratch + mark, count, start_token->offset);
 }
 
 // Parse a variable declaration
-Node *parse_variable_declaration(Parser *parser)
+NodeId parse_variable_declaration(Parser *parser)
 {
     Token *type_token = parser->current_token;
-    const char *type = type_token->value;
+    NameId type = parser_intern(parser, type_token);
     parser_advance(parser);
 
     Token *name_token = parser->current_token;
     if (!parser_expect(parser, TOKEN_IDENTIFIER))
-        return NULL;
-    const char *name = name_token->value;
+        return NODE_NONE;
+    NameId name = parser_intern(parser, name_token);
 
-    Node *initializer = NULL;
+    NodeId initializer = NODE_NONE;
     if (parser->current_token->type == TOKEN_EQUALS)
     {
         parser_advance(parser);
         initializer = parse_expression(parser);
         if (!initializer)
-            return NULL;
+            return NODE_NONE;
 
         if (!parser_expect(parser, TOKEN_SEMICOLON))
-            return NULL;
+            return NODE_NONE;
 
-        return create_var_decl_node(type, name, initializer, type_token->line, type_token->column);
+        return create_var_decl_node(parser->ast, type, name, initializer, type_token->offset);
     }
 
     if (!parser_expect(parser, TOKEN_SEMICOLON))
-        return NULL;
+        return NODE_NONE;
 
-    return create_var_decl_node(type, name, initializer, type_token->line, type_token->column);
+    return create_var_decl_node(parser->ast, type, name, initializer, type_token->offset);
 }
 
 // Parse an if statement
-Node *parse_if_statement(Parser *parser)
+NodeId parse_if_statement(Parser *parser)
 {
     Token *if_token = parser->current_token;
     parser_advance(parser); 
 
     if (!parser_expect(parser, TOKEN_LPAREN))
-        return NULL;
+        return NODE_NONE;
 
-    Node *condition = parse_expression(parser);
+    NodeId condition = parse_expression(parser);
     if (!condition)
-        return NULL;
+        return NODE_NONE;
 
     if (!parser_expect(parser, TOKEN_RPAREN))
-        return NULL;
+        return NODE_NONE;
 
-    Node *if_body = parse_block(parser);
+    NodeId if_body = parse_block(parser);
     if (!if_body)
-        return NULL;
+        return NODE_NONE;
 
-    Node *else_body = NULL;
+    NodeId else_body = NODE_NONE;
     if (parser->current_token->type == TOKEN_OTHERWISE)
     {
         parser_advance(parser);
         else_body = parse_block(parser);
         if (!else_body)
-            return NULL;
+            return NODE_NONE;
     }
 
-    return create_if_node(condition, if_body, else_body, if_token->line, if_token->column);
+    return create_if_node(parser->ast, condition, if_body, else_body, if_token->offset);
 }
 
 // Parse an assignment expression (for loop increment)
-Node *parse_assignment_expression(Parser *parser)
+NodeId parse_assignment_expression(Parser *parser)
 {
     Token *id_token = parser->current_token;
     if (id_token->type != TOKEN_IDENTIFIER)
@@ -325,90 +287,82 @@ Node *parse_assignment_expression(Parser *parser)
         return parse_expression(parser);
     }
 
-    Node *left = create_identifier_node(id_token->value, id_token->line, id_token->column);
+    NodeId left = create_identifier_node(parser->ast, parser_intern(parser, id_token), id_token->offset);
     parser_advance(parser);
 
     if (parser->current_token->type == TOKEN_EQUALS)
     {
         Token *op_token = parser->current_token;
         parser_advance(parser);
-        Node *right = parse_expression(parser);
+        NodeId right = parse_expression(parser);
         if (!right)
-            return NULL;
+            return NODE_NONE;
 
-        return create_binary_op_node(OP_ASSIGN, left, right, op_token->line, op_token->column);
+        return create_binary_op_node(parser->ast, OP_ASSIGN, left, right, op_token->offset);
     }
 
     return left;
 }
 
 // Parse a for loop
-Node *parse_for_loop(Parser *parser)
+NodeId parse_for_loop(Parser *parser)
 {
     Token *for_token = parser->current_token;
     parser_advance(parser); 
 
     if (!parser_expect(parser, TOKEN_LPAREN))
-        return NULL;
+        return NODE_NONE;
 
-    Node *initializer = parse_variable_declaration(parser);
+    NodeId initializer = parse_variable_declaration(parser);
     if (!initializer)
-        return NULL;
+        return NODE_NONE;
 
-    Node *condition = parse_expression(parser);
+    NodeId condition = parse_expression(parser);
     if (!condition)
-        return NULL;
+        return NODE_NONE;
 
     if (!parser_expect(parser, TOKEN_SEMICOLON))
-        return NULL;
-    Node *increment = parse_assignment_expression(parser);
+        return NODE_NONE;
+    NodeId increment = parse_assignment_expression(parser);
     if (!increment)
-        return NULL;
+        return NODE_NONE;
 
     if (!parser_expect(parser, TOKEN_RPAREN))
-        return NULL;
+        return NODE_NONE;
 
-    Node *body = parse_block(parser);
+    NodeId body = parse_block(parser);
     if (!body)
-        return NULL;
+        return NODE_NONE;
 
-    return create_for_node(initializer, condition, increment, body, for_token->line, for_token->column);
+    return create_for_node(parser->ast, initializer, condition, increment, body, for_token->offset);
 }
 
 // Parse a function call (show or ask)
-Node *parse_function_call(Parser *parser, Token *func_token)
+NodeId parse_function_call(Parser *parser, Token *func_token)
 {
     parser_advance(parser);
     if (!parser_expect(parser, TOKEN_LPAREN))
-        return NULL;
+        return NODE_NONE;
 
-    Node **args = NULL;
+    NodeId arg = NODE_NONE;
     int arg_count = 0;
 
     if (parser->current_token->type != TOKEN_RPAREN)
     {
-        args = malloc(sizeof(Node *));
-        args[0] = parse_expression(parser);
-        if (!args[0])
-        {
-            free(args);
-            return NULL;
-        }
+        arg = parse_expression(parser);
+        if (!arg)
+            return NODE_NONE;
         arg_count = 1;
     }
 
     if (!parser_expect(parser, TOKEN_RPAREN))
-    {
-        if (args)
-            free(args);
-        return NULL;
-    }
+        return NODE_NONE;
 
-    return create_function_call_node(func_token->value, args, arg_count, func_token->line, func_token->column);
+    return create_function_call_node(parser->ast, parser_intern(parser, func_token), &arg, arg_count, func_token->offset);
 }
 
 // Parse a statement
-Node *parse_statement(Parser *parser)
+NodeId parse_statement(Parser *parser)
 {
     switch (parser->current_token->type)
     {
@@ -425,12 +379,9 @@ Node *parse_statement(Parser *parser)
     case TOKEN_SHOW:
     case TOKEN_ASK:
     {
-        Node *func_call = parse_function_call(parser, parser->current_token);
+        NodeId func_call = parse_function_call(parser, parser->current_token);
         if (!parser_expect(parser, TOKEN_SEMICOLON))
-        {
-            free_node(func_call);
-            return NULL;
-        }
+            return NODE_NONE;
         return func_call;
     }
 
@@ -441,104 +392,93 @@ Node *parse_statement(Parser *parser)
 
         if (parser->current_token->type == TOKEN_LPAREN)
         {
-            parser_advance(parser); 
-            Node **args = NULL;
+            parser_advance(parser);
+            NodeId arg = NODE_NONE;
             int arg_count = 0;
 
             if (parser->current_token->type != TOKEN_RPAREN)
             {
-                args = (Node **)malloc(sizeof(Node *));
-                args[0] = parse_expression(parser);
-                if (!args[0])
-                {
-                    free(args);
-                    return NULL;
-                }
+                arg = parse_expression(parser);
+                if (!arg)
+                    return NODE_NONE;
                 arg_count = 1;
             }
 
             if (!parser_expect(parser, TOKEN_RPAREN))
-            {
-                if (args)
-                    free(args);
-                return NULL;
-            }
+                return NODE_NONE;
 
-            Node *func_call = create_function_call_node(token->value, args, arg_count, token->line, token->column);
+            NodeId func_call = create_function_call_node(parser->ast, parser_intern(parser, token), &arg, arg_count, token->offset);
             if (!parser_expect(parser, TOKEN_SEMICOLON))
-            {
-                free_node(func_call);
-                return NULL;
-            }
+                return NODE_NONE;
             return func_call;
         }
 
-        Node *left = create_identifier_node(token->value, token->line, token->column);
+        NodeId left = create_identifier_node(parser->ast, parser_intern(parser, token), token->offset);
 
         if (parser->current_token->type == TOKEN_EQUALS)
         {
             Token *op_token = parser->current_token;
             parser_advance(parser);
-            Node *right = parse_expression(parser);
+            NodeId right = parse_expression(parser);
             if (!right)
-            {
-                free_node(left);
-                return NULL;
-            }
+                return NODE_NONE;
             if (!parser_expect(parser, TOKEN_SEMICOLON))
-            {
-                free_node(left);
-                free_node(right);
-                return NULL;
-            }
-            return create_binary_op_node(OP_ASSIGN, left, right, op_token->line, op_token->column);
+                return NODE_NONE;
+            return create_binary_op_node(parser->ast, OP_ASSIGN, left, right, op_token->offset);
         }
         else
         {
             // Reject standalone identifiers with a more user-friendly message
+            const char *name = parser->lexer->source + token->offset;
+            int name_length = (int)token->length;
+            int line, column;
+            source_location(parser->lexer->buffer, token->offset, &line, &column);
             fprintf(stderr, "Error: Invalid statement at line %d, column %d.\n"
-                            "The identifier '%s' must be used in a proper statement like:\n"
-                            "  - Variable declaration: num %s = value;\n"
-                            "  - Assignment: %s = value;\n"
-                            "  - Function call: %s(value);\n",
-                    token->line, token->column,
-                    token->value, token->value, token->value, token->value);
-            free_node(left);
-            return NULL;
+                            "The identifier '%.*s' must be used in a proper statement like:\n"
+                            "  - Variable declaration: num %.*s = value;\n"
+                            "  - Assignment: %.*s = value;\n"
+                            "  - Function call: %.*s(value);\n",
+                    line, column,
+                    name_length, name, name_length, name, name_length, name, name_length, name);
+            return NODE_NONE;
         }
     }
 
     default:
-        fprintf(stderr, "Error: Unexpected token '%s' (%s) in statement at line %d, column %d\n",
-                parser->current_token->value ? parser->current_token->value : "EOF",
+    {
+        int length, line, column;
+        const char *value = token_value(parser->lexer, parser->current_token, &length);
+        source_location(parser->lexer->buffer, parser->current_token->offset, &line, &column);
+        fprintf(stderr, "Error: Unexpected token '%.*s' (%s) in statement at line %d, column %d\n",
+                length, value,
                 token_type_to_string(parser->current_token->type),
-                parser->current_token->line,
-                parser->current_token->column);
-        return NULL;
+                line, column);
+        return NODE_NONE;
+    }
     }
 }
 
-// Parse the entire program
-Node *parse_program(Parser *parser)
+// Parse the entire program into a tree allocated from REGION_AST
+Ast *parse_program(Parser *parser)
 {
-    Node **statements = NULL;
-    int count = 0;
+    parser->ast = create_ast();
+    parser->scratch_count = 0;
 
     while (parser->current_token->type != TOKEN_EOF)
     {
-        statements = (Node **)realloc(statements, (count + 1) * sizeof(Node *));
-        Node *stmt = parse_statement(parser);
+        NodeId stmt = parse_statement(parser);
         if (!stmt)
         {
-            for (int i = 0; i < count; i++)
-            {
-                free_node(statements[i]);
-            }
-            free(statements);
+            parser->ast = NULL;
             return NULL;
         }
-        statements[count++] = stmt;
+        parser_push_statement(parser, stmt);
     }
 
-    return create_program_node(statements, count);
+    create_program_node(parser->ast, parser->scratch, parser->scratch_count);
+    parser->scratch_count = 0;
+
+    Ast *ast = parser->ast;
+    parser->ast = NULL;
+    return ast;
 }
\ No newline at end of file
@@ -0,0 +1,257 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../include/regalloc.h"
+
+const Register machine_registers[REG_COUNT] = {
+    {"r8", false},
+    {"r9", false},
+    {"r10", false},
+    {"r11", false},
+    {"rbx", true},
+    {"rsi", true},
+    {"rdi", true},
+    {"r12", true},
+    {"r13", true},
+    {"r14", true},
+    {"r15", true},
+};
+
+RegisterAllocation *create_allocation(int value_count)
+{
+    RegisterAllocation *allocation = (RegisterAllocation *)region_calloc(REGION_IR, 1, sizeof(RegisterAllocation));
+    allocation->value_count = value_count;
+    allocation->location = (int *)region_alloc(REGION_IR, (value_count + 1) * sizeof(int));
+    allocation->slot = (int *)region_alloc(REGION_IR, (value_count + 1) * sizeof(int));
+    for (int v = 0; v < value_count; v++)
+    {
+        allocation->location[v] = REG_NONE;
+        allocation->slot[v] = FRAME_SLOT_NONE;
+    }
+    return allocation;
+}
+
+int64_t block_weight(const Cfg *cfg, int block)
+{
+    int64_t weight = 1;
+    if (cfg->blocks[block].loop >= 0)
+    {
+        for (int depth = cfg->loops[cfg->blocks[block].loop].depth; depth > 0 && weight < 10000; depth--)
+            weight *= 10;
+    }
+    return weight;
+}
+
+// One interval per value, from its first to its last live instruction in code
+// order. Blocks are laid out with loop bodies between header and latch, so a
+// value live around a loop covers all of it.
+typedef struct
+{
+    int value;
+    int start;
+    int end;
+    int64_t weight;    // uses and definitions, ten times heavier per loop level
+    bool across_call;  // live from before some call to after it
+} Interval;
+
+static int compare_start(const void *a, const void *b)
+{
+    const Interval *x = (const Interval *)a;
+    const Interval *y = (const Interval *)b;
+    if (x->start != y->start)
+        return x->start < y->start ? -1 : 1;
+    return x->value - y->value;
+}
+
+static void touch(Interval *intervals, int value, int position, int64_t weight)
+{
+    if (value < 0)
+        return;
+    Interval *interval = &intervals[value];
+    if (position < interval->start)
+        interval->start = position;
+    if (position > interval->end)
+        interval->end = position;
+    interval->weight += weight;
+}
+
+static Interval *build_intervals(const Liveness *liveness)
+{
+    const Cfg *cfg = liveness->cfg;
+    const TacBuffer *tac = cfg->tac;
+    Interval *intervals = (Interval *)region_alloc(REGION_IR, (liveness->value_count + 1) * sizeof(Interval));
+    for (int v = 0; v < liveness->value_count; v++)
+    {
+        intervals[v].value = v;
+        intervals[v].start = tac->count;
+        intervals[v].end = -1;
+        intervals[v].weight = 0;
+        intervals[v].across_call = false;
+    }
+
+    for (int b = 0; b < cfg->block_count; b++)
+    {
+        const BasicBlock *block = &cfg->blocks[b];
+        int64_t weight = block_weight(cfg, b);
+
+        for (int w = 0; w < liveness->words; w++)
+        {
+            for (uint64_t bits = liveness->live_in[b * liveness->words + w]; bits != 0; bits &= bits - 1)
+                touch(intervals, w * 64 + __builtin_ctzll(bits), block->first, 0);
+            for (uint64_t bits = liveness->live_out[b * liveness->words + w]; bits != 0; bits &= bits - 1)
+                touch(intervals, w * 64 + __builtin_ctzll(bits), block->last - 1, 0);
+        }
+        for (int i = block->first; i < block->last; i++)
+        {
+            touch(intervals, liveness_value(tac, tac->code[i].result), i, weight);
+            touch(intervals, liveness_value(tac, tac->code[i].arg1), i, weight);
+            touch(intervals, liveness_value(tac, tac->code[i].arg2), i, weight);
+        }
+    }
+
+    // Calls strictly inside an interval clobber the registers that are not preserved
+    int *calls_before = (int *)region_alloc(REGION_IR, (tac->count + 1) * sizeof(int));
+    calls_before[0] = 0;
+    for (int i = 0; i < tac->count; i++)
+        calls_before[i + 1] = calls_before[i] + (tac->code[i].op == TAC_CALL);
+    for (int v = 0; v < liveness->value_count; v++)
+    {
+        if (intervals[v].end > intervals[v].start)
+            intervals[v].across_call = calls_before[intervals[v].end] > calls_before[intervals[v].start + 1];
+    }
+    return intervals;
+}
+
+// Intervals of the values that are read or written, in order of their start
+static Interval *sorted_intervals(const Liveness *liveness, int *count)
+{
+    Interval *all = build_intervals(liveness);
+    *count = 0;
+    for (int v = 0; v < liveness->value_count; v++)
+    {
+        if (all[v].end >= 0)
+            all[(*count)++] = all[v];
+    }
+    qsort(all, *count, sizeof(Interval), compare_start);
+    return all;
+}
+
+// Values in memory whose intervals do not overlap share a slot, so variables
+// of sibling scopes and temps of different statements reuse the same few
+// cache lines. Once the frame is full, the value that stays live longest
+// moves to .bss.
+void assign_frame_slots(const Liveness *liveness, RegisterAllocation *allocation)
+{
+    int count;
+    Interval *all = sorted_intervals(liveness, &count);
+    const Interval *owner[MAX_FRAME_SLOTS];
+
+    for (int n = 0; n < count; n++)
+    {
+        const Interval *current = &all[n];
+        if (allocation->location[current->value] != REG_NONE)
+            continue;
+
+        int slot = FRAME_SLOT_GLOBAL;
+        int longest = FRAME_SLOT_GLOBAL;
+        for (int s = 0; s < allocation->frame_slots && slot == FRAME_SLOT_GLOBAL; s++)
+        {
+            if (owner[s]->end < current->start)
+                slot = s;
+            else if (longest == FRAME_SLOT_GLOBAL || owner[s]->end > owner[longest]->end)
+                longest = s;
+        }
+        if (slot == FRAME_SLOT_GLOBAL && allocation->frame_slots < MAX_FRAME_SLOTS)
+            slot = allocation->frame_slots++;
+        if (slot == FRAME_SLOT_GLOBAL && owner[longest]->end > current->end)
+        {
+            allocation->slot[owner[longest]->value] = FRAME_SLOT_GLOBAL;
+            allocation->globals++;
+            slot = longest;
+        }
+
+        allocation->slot[current->value] = slot;
+        if (slot == FRAME_SLOT_GLOBAL)
+            allocation->globals++;
+        else
+            owner[slot] = current;
+    }
+}
+
+RegisterAllocation *allocate_stack_frame(const TacBuffer *tac)
+{
+    Liveness *liveness = compute_liveness(build_cfg(tac));
+    RegisterAllocation *allocation = create_allocation(liveness->value_count);
+    assign_frame_slots(liveness, allocation);
+    return allocation;
+}
+
+static bool fits(const Interval *interval, int reg)
+{
+    return machine_registers[reg].preserved || !interval->across_call;
+}
+
+RegisterAllocation *allocate_linear_scan(const TacBuffer *tac)
+{
+    Cfg *cfg = build_cfg(tac);
+    Liveness *liveness = compute_liveness(cfg);
+    RegisterAllocation *allocation = create_allocation(liveness->value_count);
+
+    int count;
+    Interval *all = sorted_intervals(liveness, &count);
+
+    // Active intervals, one per register in use
+    const Interval *active[REG_COUNT];
+    for (int r = 0; r < REG_COUNT; r++)
+        active[r] = NULL;
+
+    for (int n = 0; n < count; n++)
+    {
+        const Interval *current = &all[n];
+        for (int r = 0; r < REG_COUNT; r++)
+        {
+            if (active[r] != NULL && active[r]->end < current->start)
+                active[r] = NULL;
+        }
+
+        // Values that survive a call need a preserved register; the others
+        // take a clobbered one first, leaving the preserved ones for them
+        int chosen = REG_NONE;
+        for (int r = 0; r < REG_COUNT && chosen == REG_NONE; r++)
+        {
+            if (active[r] == NULL && fits(current, r))
+                chosen = r;
+        }
+
+        // Under pressure the lightest value goes to memory, the one that
+        // ends last if weights tie
+        if (chosen == REG_NONE)
+        {
+            int victim = REG_NONE;
+            for (int r = 0; r < REG_COUNT; r++)
+            {
+                if (!fits(current, r))
+                    continue;
+                if (victim == REG_NONE || active[r]->weight < active[victim]->weight ||
+                    (active[r]->weight == active[victim]->weight && active[r]->end > active[victim]->end))
+                    victim = r;
+            }
+            if (victim == REG_NONE || active[victim]->weight > current->weight ||
+                (active[victim]->weight == current->weight && active[victim]->end <= current->end))
+            {
+                allocation->spilled++;
+                continue;
+            }
+            allocation->location[active[victim]->value] = REG_NONE;
+            allocation->allocated--;
+            allocation->spilled++;
+            chosen = victim;
+        }
+
+        allocation->location[current->value] = chosen;
+        allocation->allocated++;
+        active[chosen] = current;
+    }
+    assign_frame_slots(liveness, allocation);
+    return allocation;
+}
\ No newline at end of file
@@ -0,0 +1,192 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../include/optimizer.h"
+
+// Loop rotation. A repeat loop comes out of TAC generation tested at the top:
+//
+//   Lh: test; if t goto Lb; goto Lx; Lb: body; goto Lh; Lx:
+//
+// so each iteration runs a conditional and an unconditional jump. Rotation
+// moves the test below the body, where its branch is the only back edge, and
+// leaves a copy of it in front to guard entry:
+//
+//   test'; if t' goto Lb; goto Lx; Lb: body; Lh: test; if t goto Lb; Lx:
+//
+// Control that fell into Lh now runs the guard and anything that jumped to Lh
+// still reaches the test, so the rewrite needs no loop analysis. The guard
+// gets fresh temps, which is why temps the test defines may not be read
+// anywhere else.
+
+#define MAX_TEST_SIZE 8 // instructions of a test worth copying
+
+typedef struct
+{
+    int header; // LABEL Lh
+    int branch; // IF at the end of the test
+    int latch;  // the last GOTO Lh
+} Rotation;
+
+typedef enum
+{
+    PART_NONE,
+    PART_HEADER,
+    PART_LATCH
+} Part;
+
+static void count_use(int *uses, Operand operand)
+{
+    if (operand.kind == OPERAND_TEMP)
+        uses[operand.id]++;
+}
+
+// Whether code[header] starts `Lh: test; if t goto Lb; goto Lx; Lb:`, with
+// the IF's index in *branch
+static bool match_header(const TacBuffer *tac, int header, int *branch)
+{
+    int i = header + 1;
+    while (i < tac->count && i - header <= MAX_TEST_SIZE && tac->code[i].op != TAC_IF &&
+           tac->code[i].op != TAC_GOTO && tac->code[i].op != TAC_LABEL)
+        i++;
+    if (i + 2 >= tac->count || tac->code[i].op != TAC_IF || tac->code[i + 1].op != TAC_GOTO ||
+        tac->code[i + 2].op != TAC_LABEL || tac->code[i + 2].result.id != tac->code[i].result.id)
+        return false;
+    *branch = i;
+    return true;
+}
+
+// Temps the test defines must get all their uses inside it
+static bool test_is_private(const TacBuffer *tac, int header, int branch, const int *uses, int *inside)
+{
+    for (int i = header + 1; i <= branch; i++)
+    {
+        count_use(inside, tac->code[i].arg1);
+        count_use(inside, tac->code[i].arg2);
+    }
+    bool contained = true;
+    for (int i = header + 1; i < branch; i++)
+    {
+        Operand result = tac->code[i].result;
+        if (result.kind == OPERAND_TEMP && inside[result.id] != uses[result.id])
+            contained = false;
+    }
+    for (int i = header + 1; i <= branch; i++)
+    {
+        if (tac->code[i].arg1.kind == OPERAND_TEMP)
+            inside[tac->code[i].arg1.id] = 0;
+        if (tac->code[i].arg2.kind == OPERAND_TEMP)
+            inside[tac->code[i].arg2.id] = 0;
+    }
+    return contained;
+}
+
+static void emit_code(TacBuffer *tac, const TAC *code, Operand result, Operand arg1, Operand arg2)
+{
+    TAC *copy = tac_emit(tac, code->op, result, arg1, arg2, code->offset);
+    copy->type = code->type;
+}
+
+static Operand renamed(const uint32_t *rename, Operand operand)
+{
+    if (operand.kind == OPERAND_TEMP && rename[operand.id] != UINT32_MAX)
+        return make_operand(OPERAND_TEMP, rename[operand.id]);
+    return operand;
+}
+
+int rotate_loops(TacBuffer *tac, OptimizerStats *stats)
+{
+    int count = tac->count;
+    if (count == 0)
+        return 0;
+
+    int *last_jump = (int *)region_alloc(REGION_IR, (tac->label_count + 1) * sizeof(int));
+    for (uint32_t l = 0; l < tac->label_count; l++)
+        last_jump[l] = -1;
+    int *uses = (int *)region_calloc(REGION_IR, tac->temp_count + 1, sizeof(int));
+    for (int i = 0; i < count; i++)
+    {
+        if (tac->code[i].op == TAC_GOTO)
+            last_jump[tac->code[i].result.id] = i;
+        count_use(uses, tac->code[i].arg1);
+        count_use(uses, tac->code[i].arg2);
+    }
+
+    // A header or latch instruction belongs to at most one rotation
+    Part *part = (Part *)region_calloc(REGION_IR, count + 1, sizeof(Part));
+    int *rotation_at = (int *)region_alloc(REGION_IR, (count + 1) * sizeof(int));
+    Rotation *rotations = (Rotation *)region_alloc(REGION_IR, (count / 4 + 1) * sizeof(Rotation));
+    int *inside = (int *)region_calloc(REGION_IR, tac->temp_count + 1, sizeof(int));
+    int rotated = 0;
+
+    for (int h = 0; h < count; h++)
+    {
+        int branch;
+        if (tac->code[h].op != TAC_LABEL || !match_header(tac, h, &branch))
+            continue;
+        int latch = last_jump[tac->code[h].result.id];
+        if (latch <= branch + 2 || part[latch] != PART_NONE || !test_is_private(tac, h, branch, uses, inside))
+            continue;
+
+        bool unclaimed = true;
+        for (int i = h; i <= branch + 1; i++)
+            unclaimed = unclaimed && part[i] == PART_NONE;
+        if (!unclaimed)
+            continue;
+
+        for (int i = h; i <= branch + 1; i++)
+            part[i] = PART_HEADER;
+        part[latch] = PART_LATCH;
+        rotation_at[h] = rotated;
+        rotation_at[latch] = rotated;
+        rotations[rotated].header = h;
+        rotations[rotated].branch = branch;
+        rotations[rotated].latch = latch;
+        rotated++;
+    }
+    if (rotated == 0)
+        return 0;
+
+    uint32_t temps = tac->temp_count;
+    uint32_t *rename = (uint32_t *)region_alloc(REGION_IR, (temps + 1) * sizeof(uint32_t));
+    memset(rename, 0xff, (temps + 1) * sizeof(uint32_t));
+
+    TAC *old = (TAC *)region_alloc(REGION_IR, count * sizeof(TAC));
+    memcpy(old, tac->code, count * sizeof(TAC));
+    tac->count = 0;
+
+    for (int i = 0; i < count; i++)
+    {
+        if (part[i] == PART_NONE)
+        {
+            emit_code(tac, &old[i], old[i].result, old[i].arg1, old[i].arg2);
+            continue;
+        }
+
+        const Rotation *rotation = &rotations[rotation_at[i]];
+        if (part[i] == PART_HEADER)
+        {
+            // Guard: the test on fresh temps, branching into the body or past the loop
+            for (int t = rotation->header + 1; t <= rotation->branch; t++)
+            {
+                Operand result = old[t].result;
+                if (result.kind == OPERAND_TEMP)
+                    rename[result.id] = generate_temp_var(tac).id;
+                emit_code(tac, &old[t], renamed(rename, result), renamed(rename, old[t].arg1),
+                          renamed(rename, old[t].arg2));
+            }
+            const TAC *exit_jump = &old[rotation->branch + 1];
+            emit_code(tac, exit_jump, exit_jump->result, exit_jump->arg1, exit_jump->arg2);
+            i = rotation->branch + 1;
+            stats->rotated++;
+            continue;
+        }
+
+        // The test itself replaces the back edge
+        for (int t = rotation->header; t <= rotation->branch; t++)
+            emit_code(tac, &old[t], old[t].result, old[t].arg1, old[t].arg2);
+        const TAC *exit_jump = &old[rotation->branch + 1];
+        if (i + 1 >= count || old[i + 1].op != TAC_LABEL || old[i + 1].result.id != exit_jump->result.id)
+            emit_code(tac, exit_jump, exit_jump->result, exit_jump->arg1, exit_jump->arg2);
+    }
+    return rotated;
+}
\ No newline at end of file
@@ -0,0 +1,234 @@
+#include "../include/scan.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SCAN_HAVE_X86 1
+#include <immintrin.h>
+#endif
+
+// Scalar versions: the reference behaviour and the tail loop of the vector versions
+
+static inline int is_space_byte(unsigned char c)
+{
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+static inline int is_identifier_byte(unsigned char c)
+{
+    unsigned char lower = c | 0x20;
+    return (c >= '0' && c <= '9') || (lower >= 'a' && lower <= 'z') || c == '_';
+}
+
+static size_t scan_whitespace_scalar(const char *text, size_t length)
+{
+    size_t i = 0;
+    while (i < length && is_space_byte((unsigned char)text[i]))
+        i++;
+    return i;
+}
+
+static size_t scan_line_scalar(const char *text, size_t length)
+{
+    size_t i = 0;
+    while (i < length && text[i] != '\n' && text[i] != '\0')
+        i++;
+    return i;
+}
+
+static size_t scan_identifier_scalar(const char *text, size_t length)
+{
+    size_t i = 0;
+    while (i < length && is_identifier_byte((unsigned char)text[i]))
+        i++;
+    return i;
+}
+
+static size_t scan_string_body_scalar(const char *text, size_t length)
+{
+    size_t i = 0;
+    while (i < length && text[i] != '"' && text[i] != '\0')
+        i++;
+    return i;
+}
+
+#ifdef SCAN_HAVE_X86
+
+// Each *_stop helper returns a bitmask with a bit set for every byte that ends the run
+
+static inline unsigned whitespace_stop_sse2(__m128i b)
+{
+    __m128i space = _mm_cmpeq_epi8(b, _mm_set1_epi8(' '));
+    __m128i control = _mm_and_si128(_mm_cmpgt_epi8(b, _mm_set1_epi8('\t' - 1)),
+                                    _mm_cmplt_epi8(b, _mm_set1_epi8('\r' + 1)));
+    return ~(unsigned)_mm_movemask_epi8(_mm_or_si128(space, control)) & 0xFFFFu;
+}
+
+static inline unsigned line_stop_sse2(__m128i b)
+{
+    __m128i stop = _mm_or_si128(_mm_cmpeq_epi8(b, _mm_set1_epi8('\n')),
+                                _mm_cmpeq_epi8(b, _mm_setzero_si128()));
+    return (unsigned)_mm_movemask_epi8(stop);
+}
+
+static inline unsigned identifier_stop_sse2(__m128i b)
+{
+    __m128i lower = _mm_or_si128(b, _mm_set1_epi8(0x20));
+    __m128i digit = _mm_and_si128(_mm_cmpgt_epi8(b, _mm_set1_epi8('0' - 1)),
+                                  _mm_cmplt_epi8(b, _mm_set1_epi8('9' + 1)));
+    __m128i alpha = _mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)),
+                                  _mm_cmplt_epi8(lower, _mm_set1_epi8('z' + 1)));
+    __m128i under = _mm_cmpeq_epi8(b, _mm_set1_epi8('_'));
+    __m128i ok = _mm_or_si128(_mm_or_si128(digit, alpha), under);
+    return ~(unsigned)_mm_movemask_epi8(ok) & 0xFFFFu;
+}
+
+static inline unsigned string_body_stop_sse2(__m128i b)
+{
+    __m128i stop = _mm_or_si128(_mm_cmpeq_epi8(b, _mm_set1_epi8('"')),
+                                _mm_cmpeq_epi8(b, _mm_setzero_si128()));
+    return (unsigned)_mm_movemask_epi8(stop);
+}
+
+#define DEFINE_SCAN_SSE2(kind)                                                      \
+    static size_t scan_##kind##_sse2(const char *text, size_t length)               \
+    {                                                                               \
+        size_t i = 0;                                                               \
+        for (; i + 16 <= length; i += 16)                                           \
+        {                                                                           \
+            unsigned mask = kind##_stop_sse2(_mm_loadu_si128((const __m128i *)(text + i))); \
+            if (mask)                                                               \
+                return i + (size_t)__builtin_ctz(mask);                             \
+        }                                                                           \
+        return i + scan_##kind##_scalar(text + i, length - i);                      \
+    }
+
+DEFINE_SCAN_SSE2(whitespace)
+DEFINE_SCAN_SSE2(line)
+DEFINE_SCAN_SSE2(identifier)
+DEFINE_SCAN_SSE2(string_body)
+
+#define AVX2_FN __attribute__((target("avx2")))
+
+static inline AVX2_FN unsigned whitespace_stop_avx2(__m256i b)
+{
+    __m256i space = _mm256_cmpeq_epi8(b, _mm256_set1_epi8(' '));
+    __m256i control = _mm256_and_si256(_mm256_cmpgt_epi8(b, _mm256_set1_epi8('\t' - 1)),
+                                       _mm256_cmpgt_epi8(_mm256_set1_epi8('\r' + 1), b));
+    return ~(unsigned)_mm256_movemask_epi8(_mm256_or_si256(space, control));
+}
+
+static inline AVX2_FN unsigned line_stop_avx2(__m256i b)
+{
+    __m256i stop = _mm256_or_si256(_mm256_cmpeq_epi8(b, _mm256_set1_epi8('\n')),
+                                   _mm256_cmpeq_epi8(b, _mm256_setzero_si256()));
+    return (unsigned)_mm256_movemask_epi8(stop);
+}
+
+static inline AVX2_FN unsigned identifier_stop_avx2(__m256i b)
+{
+    __m256i lower = _mm256_or_si256(b, _mm256_set1_epi8(0x20));
+    __m256i digit = _mm256_and_si256(_mm256_cmpgt_epi8(b, _mm256_set1_epi8('0' - 1)),
+                                     _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), b));
+    __m256i alpha = _mm256_and_si256(_mm256_cmpgt_epi8(lower, _mm256_set1_epi8('a' - 1)),
+                                     _mm256_cmpgt_epi8(_mm256_set1_epi8('z' + 1), lower));
+    __m256i under = _mm256_cmpeq_epi8(b, _mm256_set1_epi8('_'));
+    __m256i ok = _mm256_or_si256(_mm256_or_si256(digit, alpha), under);
+    return ~(unsigned)_mm256_movemask_epi8(ok);
+}
+
+static inline AVX2_FN unsigned string_body_stop_avx2(__m256i b)
+{
+    __m256i stop = _mm256_or_si256(_mm256_cmpeq_epi8(b, _mm256_set1_epi8('"')),
+                                   _mm256_cmpeq_epi8(b, _mm256_setzero_si256()));
+    return (unsigned)_mm256_movemask_epi8(stop);
+}
+
+#define DEFINE_SCAN_AVX2(kind)                                                         \
+    static AVX2_FN size_t scan_##kind##_avx2(const char *text, size_t length)          \
+    {                                                                                  \
+        size_t i = 0;                                                                  \
+        for (; i + 32 <= length; i += 32)                                              \
+        {                                                                              \
+            unsigned mask = kind##_stop_avx2(_mm256_loadu_si256((const __m256i *)(text + i))); \
+            if (mask)                                                                  \
+                return i + (size_t)__builtin_ctz(mask);                                \
+        }                                                                              \
+        return i + scan_##kind##_sse2(text + i, length - i);                           \
+    }
+
+DEFINE_SCAN_AVX2(whitespace)
+DEFINE_SCAN_AVX2(line)
+DEFINE_SCAN_AVX2(identifier)
+DEFINE_SCAN_AVX2(string_body)
+
+#endif
+
+// Starts out scalar so the lexer works even if scan_init() was never called
+ScanFunctions scanner = {
+    scan_whitespace_scalar,
+    scan_line_scalar,
+    scan_identifier_scalar,
+    scan_string_body_scalar,
+};
+
+ScanImpl scan_best_impl(void)
+{
+#ifdef SCAN_HAVE_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return SCAN_AVX2;
+    if (__builtin_cpu_supports("sse2"))
+        return SCAN_SSE2;
+#endif
+    return SCAN_SCALAR;
+}
+
+void scan_select(ScanImpl impl)
+{
+    switch (impl)
+    {
+#ifdef SCAN_HAVE_X86
+    case SCAN_AVX2:
+        scanner.whitespace = scan_whitespace_avx2;
+        scanner.line = scan_line_avx2;
+        scanner.identifier = scan_identifier_avx2;
+        scanner.string_body = scan_string_body_avx2;
+        break;
+    case SCAN_SSE2:
+        scanner.whitespace = scan_whitespace_sse2;
+        scanner.line = scan_line_sse2;
+        scanner.identifier = scan_identifier_sse2;
+        scanner.string_body = scan_string_body_sse2;
+        break;
+#endif
+    default:
+        scanner.whitespace = scan_whitespace_scalar;
+        scanner.line = scan_line_scalar;
+        scanner.identifier = scan_identifier_scalar;
+        scanner.string_body = scan_string_body_scalar;
+        break;
+    }
+}
+
+// Pick the widest implementation the CPU supports; safe to call more than once
+void scan_init(void)
+{
+    static int initialized = 0;
+    if (!initialized)
+    {
+        scan_select(scan_best_impl());
+        initialized = 1;
+    }
+}
+
+const char *scan_impl_name(ScanImpl impl)
+{
+    switch (impl)
+    {
+    case SCAN_AVX2:
+        return "avx2";
+    case SCAN_SSE2:
+        return "sse2";
+    default:
+        return "scalar";
+    }
+}
\ No newline at end of file
@@ -0,0 +1,352 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../include/optimizer.h"
+#include "../include/ssa.h"
+
+// Sparse conditional constant propagation (Wegman and Zadeck) over the SSA
+// tables. Values only move down the lattice: unknown, then one constant, then
+// varying. Only edges found executable contribute to phis, so a branch on a
+// provable constant keeps its dead arm from polluting the join.
+
+typedef enum
+{
+    LATTICE_UNKNOWN,
+    LATTICE_CONSTANT,
+    LATTICE_VARYING
+} LatticeState;
+
+typedef struct
+{
+    LatticeState state;
+    Operand constant; // OPERAND_IMM or OPERAND_STRING
+} Lattice;
+
+typedef struct
+{
+    TacBuffer *tac;
+    const Cfg *cfg;
+    const Ssa *ssa;
+    Lattice *values;
+    bool *edge_live;    // per block * 2 + succ index
+    bool *block_live;
+    int *user_start;    // users of each value: instruction i, or phi p as -(p + 1)
+    int *users;
+    int *value_work;
+    int value_top;
+    int value_capacity;
+    int *edge_work;
+    int edge_top;
+} Sccp;
+
+static Lattice varying(void)
+{
+    Lattice lattice = {LATTICE_VARYING, {OPERAND_NONE, {0}}};
+    return lattice;
+}
+
+static Lattice constant(Operand operand)
+{
+    Lattice lattice = {LATTICE_CONSTANT, operand};
+    return lattice;
+}
+
+static Lattice meet(Lattice a, Lattice b)
+{
+    if (a.state == LATTICE_UNKNOWN)
+        return b;
+    if (b.state == LATTICE_UNKNOWN)
+        return a;
+    if (a.state == LATTICE_VARYING || b.state == LATTICE_VARYING || !operand_equal(a.constant, b.constant))
+        return varying();
+    return a;
+}
+
+static Lattice operand_lattice(const Sccp *sccp, Operand operand, int value)
+{
+    if (operand.kind == OPERAND_IMM || operand.kind == OPERAND_STRING)
+        return constant(operand);
+    if (value < 0)
+        return varying();
+    return sccp->values[value];
+}
+
+static void set_value(Sccp *sccp, int value, Lattice lattice)
+{
+    Lattice *old = &sccp->values[value];
+    if (old->state == lattice.state &&
+        (lattice.state != LATTICE_CONSTANT || operand_equal(old->constant, lattice.constant)))
+        return;
+
+    *old = lattice;
+    if (sccp->value_top >= sccp->value_capacity)
+    {
+        int grown = sccp->value_capacity * 2;
+        sccp->value_work = (int *)region_grow(REGION_IR, sccp->value_work,
+                                              sccp->value_capacity * sizeof(int), grown * sizeof(int));
+        sccp->value_capacity = grown;
+    }
+    sccp->value_work[sccp->value_top++] = value;
+}
+
+static void mark_edge(Sccp *sccp, int block, int succ_index)
+{
+    int edge = block * 2 + succ_index;
+    if (!sccp->edge_live[edge])
+    {
+        sccp->edge_live[edge] = true;
+        sccp->edge_work[sccp->edge_top++] = edge;
+    }
+}
+
+static void evaluate_phi(Sccp *sccp, int p)
+{
+    const Phi *phi = &sccp->ssa->phis[p];
+    const Ssa *ssa = sccp->ssa;
+    Lattice result = {LATTICE_UNKNOWN, {OPERAND_NONE, {0}}};
+
+    for (int j = ssa->pred_start[phi->block]; j < ssa->pred_start[phi->block + 1]; j++)
+    {
+        if (!sccp->edge_live[ssa->pred_edge[j]])
+            continue;
+        int arg = phi->args[j - ssa->pred_start[phi->block]];
+        result = meet(result, arg < 0 ? varying() : sccp->values[arg]);
+    }
+    set_value(sccp, phi->value, result);
+}
+
+static Lattice evaluate_code(const Sccp *sccp, int i)
+{
+    const TAC *code = &sccp->tac->code[i];
+    Lattice a = operand_lattice(sccp, code->arg1, sccp->ssa->use_value[i * 2]);
+
+    if (code->op == TAC_ASSIGN)
+        return a;
+    if (code->op != TAC_NEG && !tac_is_binary(code->op))
+        return varying();
+
+    Lattice b = code->op == TAC_NEG ? constant(make_imm(0)) : operand_lattice(sccp, code->arg2, sccp->ssa->use_value[i * 2 + 1]);
+    if (code->op == TAC_NEG)
+    {
+        Lattice swap = a;
+        a = b;
+        b = swap;
+    }
+    if (a.state == LATTICE_VARYING || b.state == LATTICE_VARYING)
+        return varying();
+    if (a.state == LATTICE_UNKNOWN || b.state == LATTICE_UNKNOWN)
+        return a.state == LATTICE_UNKNOWN ? a : b;
+
+    int64_t value;
+    if (a.constant.kind == OPERAND_IMM && b.constant.kind == OPERAND_IMM &&
+        tac_evaluate(code->op == TAC_NEG ? TAC_SUB : code->op, a.constant.imm, b.constant.imm, &value))
+        return constant(make_imm(value));
+    return varying();
+}
+
+// Re-evaluates one instruction of a live block, following its branch if it has one
+static void visit_code(Sccp *sccp, int i)
+{
+    const TAC *code = &sccp->tac->code[i];
+    int block = sccp->cfg->block_of[i];
+
+    if (code->op == TAC_IF)
+    {
+        Lattice condition = operand_lattice(sccp, code->arg1, sccp->ssa->use_value[i * 2]);
+        if (condition.state == LATTICE_VARYING ||
+            (condition.state == LATTICE_CONSTANT && condition.constant.kind != OPERAND_IMM))
+        {
+            for (int s = 0; s < sccp->cfg->blocks[block].succ_count; s++)
+                mark_edge(sccp, block, s);
+        }
+        else if (condition.state == LATTICE_CONSTANT)
+        {
+            // The taken edge comes first; the fallthrough, if any, second
+            int s = condition.constant.imm != 0 ? 0 : 1;
+            if (s < sccp->cfg->blocks[block].succ_count)
+                mark_edge(sccp, block, s);
+        }
+        return;
+    }
+
+    if (sccp->ssa->def_value[i] >= 0)
+        set_value(sccp, sccp->ssa->def_value[i], evaluate_code(sccp, i));
+}
+
+static void visit_block(Sccp *sccp, int b)
+{
+    const BasicBlock *block = &sccp->cfg->blocks[b];
+    sccp->block_live[b] = true;
+    for (int i = block->first; i < block->last; i++)
+        visit_code(sccp, i);
+
+    if (sccp->tac->code[block->last - 1].op != TAC_IF)
+    {
+        for (int s = 0; s < block->succ_count; s++)
+            mark_edge(sccp, b, s);
+    }
+}
+
+static void build_users(Sccp *sccp)
+{
+    const Ssa *ssa = sccp->ssa;
+    int count = sccp->tac->count;
+    sccp->user_start = (int *)region_calloc(REGION_IR, ssa->value_count + 2, sizeof(int));
+
+    // Count, then fill, instruction uses and phi arguments
+    for (int pass = 0; pass < 2; pass++)
+    {
+        int *slot = pass == 0 ? sccp->user_start : (int *)region_calloc(REGION_IR, ssa->value_count + 1, sizeof(int));
+        for (int i = 0; i < count; i++)
+        {
+            for (int a = 0; a < 2; a++)
+            {
+                int value = ssa->use_value[i * 2 + a];
+                if (value < 0)
+                    continue;
+                if (pass == 0)
+                    slot[value + 1]++;
+                else
+                    sccp->users[sccp->user_start[value] + slot[value]++] = i;
+            }
+        }
+        for (int p = 0; p < ssa->phi_count; p++)
+        {
+            int pred_count = sccp->cfg->blocks[ssa->phis[p].block].pred_count;
+            for (int j = 0; j < pred_count; j++)
+            {
+                int value = ssa->phis[p].args[j];
+                if (value < 0)
+                    continue;
+                if (pass == 0)
+                    slot[value + 1]++;
+                else
+                    sccp->users[sccp->user_start[value] + slot[value]++] = -(p + 1);
+            }
+        }
+
+        if (pass == 0)
+        {
+            for (int v = 0; v < ssa->value_count; v++)
+                sccp->user_start[v + 1] += sccp->user_start[v];
+            sccp->users = (int *)region_alloc(REGION_IR, (sccp->user_start[ssa->value_count] + 1) * sizeof(int));
+        }
+    }
+}
+
+static void solve(Sccp *sccp)
+{
+    const Cfg *cfg = sccp->cfg;
+    const Ssa *ssa = sccp->ssa;
+
+    if (cfg->block_count > 0)
+        visit_block(sccp, 0);
+
+    while (sccp->edge_top > 0 || sccp->value_top > 0)
+    {
+        if (sccp->edge_top > 0)
+        {
+            int edge = sccp->edge_work[--sccp->edge_top];
+            int target = cfg->blocks[edge / 2].succs[edge % 2];
+            for (int p = ssa->block_phis[target]; p >= 0; p = ssa->phis[p].next)
+                evaluate_phi(sccp, p);
+            if (!sccp->block_live[target])
+                visit_block(sccp, target);
+            continue;
+        }
+
+        int value = sccp->value_work[--sccp->value_top];
+        for (int u = sccp->user_start[value]; u < sccp->user_start[value + 1]; u++)
+        {
+            int user = sccp->users[u];
+            if (user < 0)
+            {
+                if (sccp->block_live[ssa->phis[-user - 1].block])
+                    evaluate_phi(sccp, -user - 1);
+            }
+            else if (sccp->block_live[cfg->block_of[user]])
+            {
+                visit_code(sccp, user);
+            }
+        }
+    }
+}
+
+// Replaces constant uses and results, turns decided branches into jumps, and
+// drops the blocks no executable edge reaches
+static int rewrite(Sccp *sccp, OptimizerStats *stats)
+{
+    TacBuffer *tac = sccp->tac;
+    const Ssa *ssa = sccp->ssa;
+    int changes = 0;
+
+    for (int i = 0; i < tac->count; i++)
+    {
+        TAC *code = &tac->code[i];
+        if (!sccp->block_live[sccp->cfg->block_of[i]])
+        {
+            code->op = TAC_NOP;
+            stats->unreachable++;
+            changes++;
+            continue;
+        }
+
+        Operand *args[] = {&code->arg1, &code->arg2};
+        for (int a = 0; a < 2; a++)
+        {
+            int value = ssa->use_value[i * 2 + a];
+            if (value >= 0 && sccp->values[value].state == LATTICE_CONSTANT)
+            {
+                *args[a] = sccp->values[value].constant;
+                stats->propagated++;
+                changes++;
+            }
+        }
+
+        if (code->op == TAC_IF && code->arg1.kind == OPERAND_IMM)
+        {
+            code->op = code->arg1.imm != 0 ? TAC_GOTO : TAC_NOP;
+            code->arg1 = NO_OPERAND;
+            stats->folded++;
+            changes++;
+        }
+        else if (ssa->def_value[i] >= 0 && code->op != TAC_ASSIGN && tac_is_pure(code) &&
+                 sccp->values[ssa->def_value[i]].state == LATTICE_CONSTANT)
+        {
+            code->op = TAC_ASSIGN;
+            code->arg1 = sccp->values[ssa->def_value[i]].constant;
+            code->arg2 = NO_OPERAND;
+            stats->folded++;
+            changes++;
+        }
+    }
+    return changes;
+}
+
+int propagate_constants(TacBuffer *tac, OptimizerStats *stats)
+{
+    if (tac->count == 0)
+        return 0;
+
+    Sccp sccp;
+    memset(&sccp, 0, sizeof(sccp));
+    sccp.tac = tac;
+    sccp.cfg = build_cfg(tac);
+    sccp.ssa = build_ssa(sccp.cfg);
+
+    int block_count = sccp.cfg->block_count;
+    sccp.values = (Lattice *)region_calloc(REGION_IR, sccp.ssa->value_count + 1, sizeof(Lattice));
+    sccp.edge_live = (bool *)region_calloc(REGION_IR, 2 * block_count + 2, sizeof(bool));
+    sccp.block_live = (bool *)region_calloc(REGION_IR, block_count + 1, sizeof(bool));
+    sccp.edge_work = (int *)region_alloc(REGION_IR, (2 * block_count + 2) * sizeof(int));
+    sccp.value_capacity = 256;
+    sccp.value_work = (int *)region_alloc(REGION_IR, sccp.value_capacity * sizeof(int));
+
+    // Variables hold whatever was stored before the program reaches them
+    for (uint32_t v = 0; v < tac->slots->count; v++)
+        sccp.values[SSA_ENTRY_VALUE(tac, v)] = varying();
+
+    build_users(&sccp);
+    solve(&sccp);
+    return rewrite(&sccp, stats);
+}
\ No newline at end of file
@@ -7,28 +7,30 @@
 
 SemanticContext *create_semantic_context(void)
 {
-    SemanticContext *context = (SemanticContext *)malloc(sizeof(SemanticContext));
-    context->symbol_table = create_symbol_table(256); 
-    context->errors = (SemanticError *)malloc(INITIAL_ERROR_CAPACITY * sizeof(SemanticError));
+    SemanticContext *context = (SemanticContext *)region_alloc(REGION_SYMBOLS, sizeof(SemanticContext));
+    context->ast = NULL;
+    context->symbol_table = create_symbol_table(64);
+    context->slots = create_slot_table();
+    context->errors = (SemanticError *)region_alloc(REGION_SYMBOLS, INITIAL_ERROR_CAPACITY * sizeof(SemanticError));
     context->error_count = 0;
     context->error_capacity = INITIAL_ERROR_CAPACITY;
     return context;
 }
 
 void add_semantic_error(SemanticContext *context, SemanticErrorType type,
-                        const char *message, int line, int column)
+                        const char *message, uint32_t offset)
 {
     if (context->error_count >= context->error_capacity)
     {
+        context->errors = (SemanticError *)region_grow(REGION_SYMBOLS, context->errors,
+                                                       context->error_capacity * sizeof(SemanticError),
+                                                       context->error_capacity * 2 * sizeof(SemanticError));
         context->error_capacity *= 2;
-        context->errors = (SemanticError *)realloc(context->errors,
-                                                   context->error_capacity * sizeof(SemanticError));
     }
     SemanticError *error = &context->errors[context->error_count++];
     error->type = type;
-    error->message = strdup(message);
-    error->line = line;
-    error->column = column;
+    error->message = region_strdup(REGION_SYMBOLS, message);
+    error->offset = offset;
 }
 
 const char *get_error_type_string(SemanticErrorType type)
@@ -52,12 +54,14 @@ const char *get_error_type_string(SemanticErrorType type)
     }
 }
 
+static void analyze_node(SemanticContext *context, NodeId id);
+
 static DataType analyze_binary_op(SemanticContext *context, Node *node)
 {
     DataType left_type = get_expression_type(context, node->binary_op.left);
     DataType right_type = get_expression_type(context, node->binary_op.right);
 
-    switch (node->binary_op.op)
+    switch (node->op)
     {
     case OP_ADD:
     case OP_SUBTRACT:
@@ -67,19 +71,18 @@ static DataType analyze_binary_op(SemanticContext *context, Node *node)
         {
             add_semantic_error(context, ERROR_TYPE_MISMATCH,
                                "Arithmetic operations require numeric operands",
-                               node->binary_op.info.line,
-                               node->binary_op.info.column);
+                               node->offset);
             return TYPE_NUM; 
         }
-        if (node->binary_op.right->type == NODE_NUMBER)
+        const Node *right = ast_node(context->ast, node->binary_op.right);
+        if (right->type == NODE_NUMBER)
         {
-            double divisor = (double)node->binary_op.right->number.value;
+            double divisor = (double)right->number;
             if (divisor == 0.0)
             {
                 add_semantic_error(context, ERROR_INVALID_OPERATION,
                                    "Division by zero detected",
-                                   node->binary_op.info.line,
-                                   node->binary_op.info.column);
+                                   node->offset);
             }
         }
         return TYPE_NUM;
@@ -90,8 +93,7 @@ static DataType analyze_binary_op(SemanticContext *context, Node *node)
         {
             add_semantic_error(context, ERROR_TYPE_MISMATCH,
                                "Comparison operators require operands of the same type",
-                               node->binary_op.info.line,
-                               node->binary_op.info.column);
+                               node->offset);
         }
         return TYPE_NUM; 
 
@@ -100,34 +102,31 @@ static DataType analyze_binary_op(SemanticContext *context, Node *node)
         {
             add_semantic_error(context, ERROR_TYPE_MISMATCH,
                                "Cannot assign value of different type",
-                               node->binary_op.info.line,
-                               node->binary_op.info.column);
+                               node->offset);
         }
         return left_type;
 
     default:
         add_semantic_error(context, ERROR_INVALID_OPERATION,
                            "Unknown binary operator",
-                           node->binary_op.info.line,
-                           node->binary_op.info.column);
+                           node->offset);
         return TYPE_NUM;
     }
 }
 
-static DataType get_function_return_type(const char *func_name)
+static DataType get_function_return_type(NameId func_name)
 {
-    if (strcmp(func_name, "ask") == 0)
+    if (func_name == NAME_ASK)
         return TYPE_STR;
-    else if (strcmp(func_name, "show") == 0)
+    else if (func_name == NAME_SHOW)
         return TYPE_VOID;
     return TYPE_VOID;
 }
 
-DataType get_expression_type(SemanticContext *context, Node *expr)
-{
-    if (!expr)
-        return TYPE_VOID;
+static void analyze_function_call(SemanticContext *context, Node *node);
 
+static DataType infer_expression_type(SemanticContext *context, Node *expr)
+{
     switch (expr->type)
     {
     case NODE_NUMBER:
@@ -142,18 +141,19 @@ DataType get_expression_type(SemanticContext *context, Node *expr)
         if (!symbol)
         {
             char error_msg[256];
-            snprintf(error_msg, sizeof(error_msg), "Use of undefined variable '%s'", expr->identifier.name);
+            snprintf(error_msg, sizeof(error_msg), "Use of undefined variable '%s'", name_str(expr->identifier.name));
             add_semantic_error(context, ERROR_UNDEFINED_VARIABLE,
-                               error_msg, expr->identifier.info.line, expr->identifier.info.column);
+                               error_msg, expr->offset);
             return TYPE_VOID;
         }
         if (!symbol->is_initialized)
         {
             char error_msg[256];
-            snprintf(error_msg, sizeof(error_msg), "Variable '%s' is used before being initialized", expr->identifier.name);
+            snprintf(error_msg, sizeof(error_msg), "Variable '%s' is used before being initialized", name_str(expr->identifier.name));
             add_semantic_error(context, ERROR_UNINITIALIZED_VARIABLE,
-                               error_msg, expr->identifier.info.line, expr->identifier.info.column);
+                               error_msg, expr->offset);
         }
+        expr->identifier.slot = symbol->slot;
         return symbol->data_type;
     }
 
@@ -161,6 +161,7 @@ DataType get_expression_type(SemanticContext *context, Node *expr)
         return analyze_binary_op(context, expr);
 
     case NODE_FUNCTION_CALL:
+        analyze_function_call(context, expr);
         return get_function_return_type(expr->function_call.name);
 
     default:
@@ -168,19 +169,42 @@ DataType get_expression_type(SemanticContext *context, Node *expr)
     }
 }
 
+DataType get_expression_type(SemanticContext *context, NodeId id)
+{
+    if (!id)
+        return TYPE_VOID;
+
+    Node *expr = ast_node(context->ast, id);
+    DataType type = infer_expression_type(context, expr);
+    expr->data_type = (uint8_t)type;
+    return type;
+}
+
+// Scopes are exited through here so the scope's storage slots become reusable
+static void exit_scope(SemanticContext *context)
+{
+    SymbolTable *table = context->symbol_table;
+    for (int i = table->scope_starts[table->scope_level - 1]; i < table->symbol_count; i++)
+    {
+        slot_table_release(context->slots, table->symbols[i].slot);
+    }
+    symbol_table_exit_scope(table);
+}
+
 static void analyze_variable_declaration(SemanticContext *context, Node *node)
 {
-    DataType var_type = strcmp(node->var_decl.type, "num") == 0 ? TYPE_NUM : TYPE_STR;
+    DataType var_type = node->var_decl.type == NAME_NUM ? TYPE_NUM : TYPE_STR;
 
     if (!symbol_table_insert(context->symbol_table, node->var_decl.name,
                              SYMBOL_VARIABLE, var_type))
     {
         add_semantic_error(context, ERROR_DUPLICATE_VARIABLE,
                            "Variable already declared in this scope",
-                           node->var_decl.info.line,
-                           node->var_decl.info.column);
+                           node->offset);
         return;
     }
+    node->var_decl.slot = slot_table_bind(context->slots, node->var_decl.name, var_type);
+    symbol_table_lookup(context->symbol_table, node->var_decl.name)->slot = node->var_decl.slot;
 
     if (node->var_decl.initializer)
     {
@@ -189,10 +213,9 @@ static void analyze_variable_declaration(SemanticContext *context, Node *node)
         {
             add_semantic_error(context, ERROR_TYPE_MISMATCH,
                                "Initializer type does not match variable type",
-                               node->var_decl.info.line,
-                               node->var_decl.info.column);
+                               node->offset);
         }
-        else if (node->var_decl.initializer->type == NODE_FUNCTION_CALL)
+        else if (ast_node(context->ast, node->var_decl.initializer)->type == NODE_FUNCTION_CALL)
         {
             symbol_table_set_initialized(context->symbol_table, node->var_decl.name);
         }
@@ -210,18 +233,17 @@ static void analyze_if_statement(SemanticContext *context, Node *node)
     {
         add_semantic_error(context, ERROR_TYPE_MISMATCH,
                            "If condition must be a numeric expression",
-                           node->if_stmt.info.line,
-                           node->if_stmt.info.column);
+                           node->offset);
     }
     symbol_table_enter_scope(context->symbol_table);
-    analyze_program(context, node->if_stmt.if_body);
-    symbol_table_exit_scope(context->symbol_table);
+    analyze_node(context, node->if_stmt.if_body);
+    exit_scope(context);
 
     if (node->if_stmt.else_body)
     {
         symbol_table_enter_scope(context->symbol_table);
-        analyze_program(context, node->if_stmt.else_body);
-        symbol_table_exit_scope(context->symbol_table);
+        analyze_node(context, node->if_stmt.else_body);
+        exit_scope(context);
     }
 }
 
@@ -231,7 +253,7 @@ static void analyze_for_loop(SemanticContext *context, Node *node)
 
     if (node->for_loop.initializer)
     {
-        analyze_program(context, node->for_loop.initializer);
+        analyze_node(context, node->for_loop.initializer);
     }
 
     if (node->for_loop.condition)
@@ -241,40 +263,41 @@ static void analyze_for_loop(SemanticContext *context, Node *node)
         {
             add_semantic_error(context, ERROR_TYPE_MISMATCH,
                                "For loop condition must be a numeric expression",
-                               node->for_loop.info.line,
-                               node->for_loop.info.column);
+                               node->offset);
         }
     }
 
     if (node->for_loop.increment)
     {
-        analyze_program(context, node->for_loop.increment);
+        analyze_node(context, node->for_loop.increment);
     }
 
-    analyze_program(context, node->for_loop.body);
-    symbol_table_exit_scope(context->symbol_table);
+    analyze_node(context, node->for_loop.body);
+    exit_scope(context);
 }
 
 static void analyze_function_call(SemanticContext *context, Node *node)
 {
-    for (int i = 0; i < node->function_call.arg_count; i++)
+    for (uint32_t i = 0; i < node->function_call.arguments.count; i++)
     {
-        Node *arg = node->function_call.arguments[i];
-        DataType arg_type = get_expression_type(context, arg);
+        get_expression_type(context, ast_child(context->ast, node->function_call.arguments, i));
     }
+    node->data_type = (uint8_t)get_function_return_type(node->function_call.name);
 }
 
-bool analyze_program(SemanticContext *context, Node *node)
+static void analyze_node(SemanticContext *context, NodeId id)
 {
-    if (!node)
-        return true;
+    if (!id)
+        return;
+
+    Node *node = ast_node(context->ast, id);
     switch (node->type)
     {
     case NODE_PROGRAM:
     case NODE_BLOCK:
-        for (int i = 0; i < node->block.count; i++)
+        for (uint32_t i = 0; i < node->block.count; i++)
         {
-            analyze_program(context, node->block.statements[i]);
+            analyze_node(context, ast_child(context->ast, node->block, i));
         }
         break;
 
@@ -291,7 +314,7 @@ bool analyze_program(SemanticContext *context, Node *node)
         break;
 
     case NODE_BINARY_OP:
-        get_expression_type(context, node);
+        get_expression_type(context, id);
         break;
 
     case NODE_FUNCTION_CALL:
@@ -301,21 +324,12 @@ bool analyze_program(SemanticContext *context, Node *node)
     default:
         break;
     }
-
-    return context->error_count == 0;
 }
 
-void free_semantic_context(SemanticContext *context)
+bool analyze_program(SemanticContext *context, Ast *ast)
 {
-    if (!context)
-        return;
-
-    free_symbol_table(context->symbol_table);
-
-    for (int i = 0; i < context->error_count; i++)
-    {
-        free(context->errors[i].message);
-    }
-    free(context->errors);
-    free(context);
+    context->ast = ast;
+    ast->slots = context->slots;
+    analyze_node(context, ast->root);
+    return context->error_count == 0;
 }
\ No newline at end of file
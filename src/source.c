@@ -0,0 +1,238 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../include/source.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#define STREAM_CHUNK_SIZE 65536
+
+// Read everything from a non-seekable stream, growing the buffer geometrically
+static int source_read_stream(SourceBuffer *source, FILE *file)
+{
+    size_t capacity = STREAM_CHUNK_SIZE;
+    size_t length = 0;
+    char *buffer = (char *)malloc(capacity);
+    if (!buffer)
+        return 0;
+
+    for (;;)
+    {
+        if (capacity - length < STREAM_CHUNK_SIZE)
+        {
+            capacity *= 2;
+            char *grown = (char *)realloc(buffer, capacity);
+            if (!grown)
+            {
+                free(buffer);
+                return 0;
+            }
+            buffer = grown;
+        }
+
+        size_t read_size = fread(buffer + length, 1, STREAM_CHUNK_SIZE, file);
+        length += read_size;
+        if (read_size < STREAM_CHUNK_SIZE)
+            break;
+    }
+
+    source->text = buffer;
+    source->length = length;
+    source->kind = SOURCE_STREAMED;
+    source->mapping = NULL;
+    return 1;
+}
+
+#ifdef _WIN32
+
+static int source_map_file(SourceBuffer *source, const char *filename)
+{
+    HANDLE file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+        return 0;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size))
+    {
+        CloseHandle(file);
+        return 0;
+    }
+
+    // Empty files cannot be mapped
+    if (size.QuadPart == 0)
+    {
+        CloseHandle(file);
+        source->text = "";
+        source->length = 0;
+        source->kind = SOURCE_MAPPED;
+        source->mapping = NULL;
+        return 1;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(file);
+    if (!mapping)
+        return 0;
+
+    const char *view = (const char *)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!view)
+    {
+        CloseHandle(mapping);
+        return 0;
+    }
+
+    source->text = view;
+    source->length = (size_t)size.QuadPart;
+    source->kind = SOURCE_MAPPED;
+    source->mapping = mapping;
+    return 1;
+}
+
+static void source_unmap(SourceBuffer *source)
+{
+    if (source->mapping)
+    {
+        UnmapViewOfFile(source->text);
+        CloseHandle((HANDLE)source->mapping);
+    }
+}
+
+#else
+
+static int source_map_file(SourceBuffer *source, const char *filename)
+{
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0)
+        return 0;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0)
+    {
+        close(fd);
+        return 0;
+    }
+
+    // Named pipes and devices cannot be mapped; read them like stdin
+    if (!S_ISREG(info.st_mode))
+    {
+        FILE *file = fdopen(fd, "rb");
+        int ok = file && source_read_stream(source, file);
+        if (file)
+            fclose(file);
+        else
+            close(fd);
+        return ok;
+    }
+
+    if (info.st_size == 0)
+    {
+        close(fd);
+        source->text = "";
+        source->length = 0;
+        source->kind = SOURCE_MAPPED;
+        source->mapping = NULL;
+        return 1;
+    }
+
+    void *view = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (view == MAP_FAILED)
+        return 0;
+
+    source->text = (const char *)view;
+    source->length = (size_t)info.st_size;
+    source->kind = SOURCE_MAPPED;
+    source->mapping = view;
+    return 1;
+}
+
+static void source_unmap(SourceBuffer *source)
+{
+    if (source->mapping)
+        munmap(source->mapping, source->length);
+}
+
+#endif
+
+// Load a program: regular files are mapped read-only, a NULL filename reads stdin
+SourceBuffer *source_open(const char *filename)
+{
+    SourceBuffer *source = (SourceBuffer *)malloc(sizeof(SourceBuffer));
+    if (!source)
+        return NULL;
+
+    int ok = filename ? source_map_file(source, filename) : source_read_stream(source, stdin);
+    if (!ok)
+    {
+        free(source);
+        return NULL;
+    }
+    source->line_starts = NULL;
+    source->line_count = 0;
+    return source;
+}
+
+static void source_build_line_index(SourceBuffer *source)
+{
+    int capacity = 64;
+    source->line_starts = (uint32_t *)malloc(capacity * sizeof(uint32_t));
+    source->line_starts[0] = 0;
+    source->line_count = 1;
+
+    const char *text = source->text;
+    const char *end = text + source->length;
+    const char *newline;
+    while ((newline = memchr(text, '\n', end - text)) != NULL)
+    {
+        if (source->line_count >= capacity)
+        {
+            capacity *= 2;
+            source->line_starts = (uint32_t *)realloc(source->line_starts, capacity * sizeof(uint32_t));
+        }
+        text = newline + 1;
+        source->line_starts[source->line_count++] = (uint32_t)(text - source->text);
+    }
+}
+
+// Turn a byte offset into a 1-based line and column, for diagnostics and dumps only
+void source_location(SourceBuffer *source, uint32_t offset, int *line, int *column)
+{
+    if (!source->line_starts)
+        source_build_line_index(source);
+
+    // Last line starting at or before offset
+    int low = 0;
+    int high = source->line_count - 1;
+    while (low < high)
+    {
+        int mid = (low + high + 1) / 2;
+        if (source->line_starts[mid] <= offset)
+            low = mid;
+        else
+            high = mid - 1;
+    }
+
+    *line = low + 1;
+    *column = (int)(offset - source->line_starts[low]) + 1;
+}
+
+void source_close(SourceBuffer *source)
+{
+    if (!source)
+        return;
+
+    if (source->kind == SOURCE_MAPPED)
+        source_unmap(source);
+    else
+        free((char *)source->text);
+    free(source->line_starts);
+    free(source);
+}
\ No newline at end of file
@@ -0,0 +1,316 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../include/ssa.h"
+
+// Lists of ints, one per block, sharing a single array
+typedef struct
+{
+    int *start;
+    int *items;
+} BlockLists;
+
+static void map_pred_edges(Ssa *ssa)
+{
+    const Cfg *cfg = ssa->cfg;
+    int total = 0;
+    ssa->pred_start = (int *)region_alloc(REGION_IR, (cfg->block_count + 1) * sizeof(int));
+    for (int b = 0; b < cfg->block_count; b++)
+    {
+        ssa->pred_start[b] = total;
+        total += cfg->blocks[b].pred_count;
+    }
+    ssa->pred_start[cfg->block_count] = total;
+
+    // Predecessor lists were filled in this same order by build_cfg
+    int *filled = (int *)region_calloc(REGION_IR, cfg->block_count + 1, sizeof(int));
+    ssa->pred_edge = (int *)region_alloc(REGION_IR, (total + 1) * sizeof(int));
+    for (int p = 0; p < cfg->block_count; p++)
+    {
+        for (int s = 0; s < cfg->blocks[p].succ_count; s++)
+        {
+            int b = cfg->blocks[p].succs[s];
+            ssa->pred_edge[ssa->pred_start[b] + filled[b]++] = p * 2 + s;
+        }
+    }
+}
+
+// A block's frontier holds the joins it reaches without dominating them
+static BlockLists dominance_frontiers(const Cfg *cfg)
+{
+    BlockLists frontier;
+    int *count = (int *)region_calloc(REGION_IR, cfg->block_count + 1, sizeof(int));
+    int *stamp = (int *)region_alloc(REGION_IR, (cfg->block_count + 1) * sizeof(int));
+    frontier.start = (int *)region_alloc(REGION_IR, (cfg->block_count + 1) * sizeof(int));
+
+    // Two sweeps over the same walk: count, then fill
+    for (int pass = 0; pass < 2; pass++)
+    {
+        for (int b = 0; b < cfg->block_count; b++)
+            stamp[b] = -1;
+        for (int b = 0; b < cfg->block_count; b++)
+        {
+            const BasicBlock *block = &cfg->blocks[b];
+            if (block->rpo < 0 || block->pred_count < 2)
+                continue;
+            for (int p = 0; p < block->pred_count; p++)
+            {
+                for (int runner = block->preds[p];
+                     runner >= 0 && runner != block->idom && cfg->blocks[runner].rpo >= 0 && stamp[runner] != b;
+                     runner = cfg->blocks[runner].idom)
+                {
+                    stamp[runner] = b;
+                    if (pass == 0)
+                        count[runner]++;
+                    else
+                        frontier.items[frontier.start[runner] + count[runner]++] = b;
+                }
+            }
+        }
+
+        if (pass == 0)
+        {
+            int total = 0;
+            for (int b = 0; b < cfg->block_count; b++)
+            {
+                frontier.start[b] = total;
+                total += count[b];
+                count[b] = 0;
+            }
+            frontier.start[cfg->block_count] = total;
+            frontier.items = (int *)region_alloc(REGION_IR, (total + 1) * sizeof(int));
+        }
+    }
+    return frontier;
+}
+
+static int add_phi(Ssa *ssa, int *capacity, int block, SlotId var)
+{
+    if (ssa->phi_count >= *capacity)
+    {
+        int grown = *capacity ? *capacity * 2 : 64;
+        ssa->phis = (Phi *)region_grow(REGION_IR, ssa->phis, *capacity * sizeof(Phi), grown * sizeof(Phi));
+        *capacity = grown;
+    }
+
+    int pred_count = ssa->cfg->blocks[block].pred_count;
+    Phi *phi = &ssa->phis[ssa->phi_count];
+    phi->block = block;
+    phi->var = var;
+    phi->value = -1;
+    phi->args = (int *)region_alloc(REGION_IR, (pred_count + 1) * sizeof(int));
+    for (int p = 0; p < pred_count; p++)
+        phi->args[p] = -1;
+    phi->next = ssa->block_phis[block];
+    ssa->block_phis[block] = ssa->phi_count;
+    return ssa->phi_count++;
+}
+
+static void place_phis(Ssa *ssa)
+{
+    const Cfg *cfg = ssa->cfg;
+    const TacBuffer *tac = cfg->tac;
+    uint32_t var_count = tac->slots->count;
+    BlockLists frontier = dominance_frontiers(cfg);
+
+    // Blocks that assign each variable, grouped by variable
+    int *def_start = (int *)region_calloc(REGION_IR, var_count + 1, sizeof(int));
+    for (int i = 0; i < tac->count; i++)
+    {
+        if (tac->code[i].result.kind == OPERAND_VAR && cfg->blocks[cfg->block_of[i]].rpo >= 0)
+            def_start[tac->code[i].result.id + 1]++;
+    }
+    for (uint32_t v = 0; v < var_count; v++)
+        def_start[v + 1] += def_start[v];
+    int *def_blocks = (int *)region_alloc(REGION_IR, (def_start[var_count] + 1) * sizeof(int));
+    int *filled = (int *)region_calloc(REGION_IR, var_count + 1, sizeof(int));
+    for (int i = 0; i < tac->count; i++)
+    {
+        SlotId var = tac->code[i].result.id;
+        if (tac->code[i].result.kind == OPERAND_VAR && cfg->blocks[cfg->block_of[i]].rpo >= 0)
+            def_blocks[def_start[var] + filled[var]++] = cfg->block_of[i];
+    }
+
+    int *has_phi = (int *)region_calloc(REGION_IR, cfg->block_count + 1, sizeof(int));
+    int *queued = (int *)region_calloc(REGION_IR, cfg->block_count + 1, sizeof(int));
+    int *work = (int *)region_alloc(REGION_IR, (cfg->block_count + 1) * sizeof(int));
+    int capacity = 0;
+
+    for (SlotId var = 1; var < var_count; var++)
+    {
+        int top = 0;
+        for (int d = def_start[var]; d < def_start[var + 1]; d++)
+        {
+            if (queued[def_blocks[d]] != (int)var)
+            {
+                queued[def_blocks[d]] = var;
+                work[top++] = def_blocks[d];
+            }
+        }
+        while (top > 0)
+        {
+            int b = work[--top];
+            for (int f = frontier.start[b]; f < frontier.start[b + 1]; f++)
+            {
+                int join = frontier.items[f];
+                if (has_phi[join] == (int)var)
+                    continue;
+                has_phi[join] = var;
+                add_phi(ssa, &capacity, join, var);
+                if (queued[join] != (int)var)
+                {
+                    queued[join] = var;
+                    work[top++] = join;
+                }
+            }
+        }
+    }
+}
+
+// Walks the dominator tree keeping the current version of every variable;
+// each block's definitions are undone when its subtree is finished
+static void rename_values(Ssa *ssa)
+{
+    const Cfg *cfg = ssa->cfg;
+    const TacBuffer *tac = cfg->tac;
+    uint32_t var_count = tac->slots->count;
+    int next_value = (int)tac->temp_count + (int)var_count;
+
+    int *current = (int *)region_alloc(REGION_IR, (var_count + 1) * sizeof(int));
+    for (uint32_t v = 0; v < var_count; v++)
+        current[v] = SSA_ENTRY_VALUE(tac, v);
+
+    int *child_start = (int *)region_calloc(REGION_IR, cfg->block_count + 2, sizeof(int));
+    for (int b = 1; b < cfg->block_count; b++)
+    {
+        if (cfg->blocks[b].idom >= 0)
+            child_start[cfg->blocks[b].idom + 1]++;
+    }
+    for (int b = 0; b < cfg->block_count; b++)
+        child_start[b + 1] += child_start[b];
+    int *children = (int *)region_alloc(REGION_IR, (child_start[cfg->block_count] + 1) * sizeof(int));
+    int *filled = (int *)region_calloc(REGION_IR, cfg->block_count + 1, sizeof(int));
+    for (int b = 1; b < cfg->block_count; b++)
+    {
+        int parent = cfg->blocks[b].idom;
+        if (parent >= 0)
+            children[child_start[parent] + filled[parent]++] = b;
+    }
+
+    // The undo log holds (variable, previous version) pairs
+    int log_capacity = 2 * (tac->count + ssa->phi_count + 1);
+    int *undo = (int *)region_alloc(REGION_IR, log_capacity * sizeof(int));
+    int *log_mark = (int *)region_alloc(REGION_IR, (cfg->block_count + 1) * sizeof(int));
+    int *stack = (int *)region_alloc(REGION_IR, 2 * (cfg->block_count + 1) * sizeof(int));
+    int log_top = 0;
+    int top = 0;
+
+    if (cfg->order_count > 0)
+        stack[top++] = 0;
+    while (top > 0)
+    {
+        int entry = stack[--top];
+        if (entry < 0)
+        {
+            int b = -entry - 1;
+            while (log_top > log_mark[b])
+            {
+                log_top -= 2;
+                current[undo[log_top]] = undo[log_top + 1];
+            }
+            continue;
+        }
+
+        int b = entry;
+        const BasicBlock *block = &cfg->blocks[b];
+        log_mark[b] = log_top;
+
+        for (int p = ssa->block_phis[b]; p >= 0; p = ssa->phis[p].next)
+        {
+            Phi *phi = &ssa->phis[p];
+            phi->value = next_value++;
+            ssa->value_var[phi->value] = phi->var;
+            undo[log_top++] = phi->var;
+            undo[log_top++] = current[phi->var];
+            current[phi->var] = phi->value;
+        }
+
+        for (int i = block->first; i < block->last; i++)
+        {
+            const TAC *code = &tac->code[i];
+            const Operand args[] = {code->arg1, code->arg2};
+            for (int a = 0; a < 2; a++)
+            {
+                if (args[a].kind == OPERAND_VAR)
+                    ssa->use_value[i * 2 + a] = current[args[a].id];
+                else if (args[a].kind == OPERAND_TEMP)
+                    ssa->use_value[i * 2 + a] = (int)args[a].id;
+            }
+
+            if (code->result.kind == OPERAND_VAR)
+            {
+                int value = next_value++;
+                ssa->value_var[value] = code->result.id;
+                undo[log_top++] = code->result.id;
+                undo[log_top++] = current[code->result.id];
+                current[code->result.id] = value;
+                ssa->def_value[i] = value;
+            }
+            else if (code->result.kind == OPERAND_TEMP)
+            {
+                ssa->def_value[i] = (int)code->result.id;
+            }
+        }
+
+        for (int s = 0; s < block->succ_count; s++)
+        {
+            int succ = block->succs[s];
+            for (int j = ssa->pred_start[succ]; j < ssa->pred_start[succ + 1]; j++)
+            {
+                if (ssa->pred_edge[j] != b * 2 + s)
+                    continue;
+                for (int p = ssa->block_phis[succ]; p >= 0; p = ssa->phis[p].next)
+                    ssa->phis[p].args[j - ssa->pred_start[succ]] = current[ssa->phis[p].var];
+            }
+        }
+
+        stack[top++] = -b - 1;
+        for (int c = child_start[b]; c < child_start[b + 1]; c++)
+            stack[top++] = children[c];
+    }
+
+    ssa->value_count = next_value;
+}
+
+Ssa *build_ssa(const Cfg *cfg)
+{
+    const TacBuffer *tac = cfg->tac;
+    Ssa *ssa = (Ssa *)region_calloc(REGION_IR, 1, sizeof(Ssa));
+    ssa->cfg = cfg;
+
+    ssa->def_value = (int *)region_alloc(REGION_IR, (tac->count + 1) * sizeof(int));
+    ssa->use_value = (int *)region_alloc(REGION_IR, 2 * (tac->count + 1) * sizeof(int));
+    for (int i = 0; i < tac->count; i++)
+    {
+        ssa->def_value[i] = -1;
+        ssa->use_value[i * 2] = -1;
+        ssa->use_value[i * 2 + 1] = -1;
+    }
+
+    ssa->block_phis = (int *)region_alloc(REGION_IR, (cfg->block_count + 1) * sizeof(int));
+    for (int b = 0; b < cfg->block_count; b++)
+        ssa->block_phis[b] = -1;
+
+    map_pred_edges(ssa);
+    place_phis(ssa);
+
+    // Every value the renaming can create: temps, entry versions, one per
+    // variable assignment and one per phi
+    int bound = (int)tac->temp_count + (int)tac->slots->count + tac->count + ssa->phi_count + 1;
+    ssa->value_var = (SlotId *)region_calloc(REGION_IR, bound, sizeof(SlotId));
+    for (uint32_t v = 0; v < tac->slots->count; v++)
+        ssa->value_var[SSA_ENTRY_VALUE(tac, v)] = v;
+
+    rename_values(ssa);
+    return ssa;
+}
\ No newline at end of file
@@ -3,112 +3,143 @@
 #include <string.h>
 #include "../include/symbol_table.h"
 
-// Simple hash function for strings
-static unsigned int hash(const char *str, int size)
+#define MIN_SYMBOL_SLOTS 16
+
+// Names are interned, so the hash is a Fibonacci (multiplicative) mix of the ID
+static uint32_t hash(const SymbolTable *table, NameId name)
+{
+    return (uint32_t)(name * 2654435769u) >> table->shift;
+}
+
+static void init_slots(SymbolTable *table, uint32_t capacity)
+{
+    int bits = 0;
+    while ((1u << bits) < capacity)
+        bits++;
+    table->capacity = 1u << bits;
+    table->shift = 32 - bits;
+    table->used = 0;
+    table->slots = (SymbolSlot *)region_calloc(REGION_SYMBOLS, table->capacity, sizeof(SymbolSlot));
+}
+
+// Linear probe for name; returns its slot or the empty slot where it belongs
+static SymbolSlot *find_slot(const SymbolTable *table, NameId name)
+{
+    uint32_t mask = table->capacity - 1;
+    uint32_t index = hash(table, name);
+    while (table->slots[index].name != NAME_NONE && table->slots[index].name != name)
+        index = (index + 1) & mask;
+    return &table->slots[index];
+}
+
+// Double the slot array. Names with no live binding are dropped while rehashing.
+static void grow_slots(SymbolTable *table)
 {
-    unsigned int hash = 0;
-    while (*str)
+    SymbolSlot *old_slots = table->slots;
+    uint32_t old_capacity = table->capacity;
+
+    init_slots(table, old_capacity * 2);
+    for (uint32_t i = 0; i < old_capacity; i++)
     {
-        hash = (hash * 31 + *str) % size;
-        str++;
+        if (old_slots[i].name != NAME_NONE && old_slots[i].symbol >= 0)
+        {
+            *find_slot(table, old_slots[i].name) = old_slots[i];
+            table->used++;
+        }
     }
-    return hash;
 }
 
 SymbolTable *create_symbol_table(int size)
 {
-    SymbolTable *table = (SymbolTable *)malloc(sizeof(SymbolTable));
-    table->size = size;
+    SymbolTable *table = (SymbolTable *)region_alloc(REGION_SYMBOLS, sizeof(SymbolTable));
+    init_slots(table, size * 2 > MIN_SYMBOL_SLOTS ? (uint32_t)size * 2 : MIN_SYMBOL_SLOTS);
+    table->symbol_count = 0;
+    table->symbol_capacity = size > 0 ? size : 1;
+    table->symbols = (Symbol *)region_alloc(REGION_SYMBOLS, table->symbol_capacity * sizeof(Symbol));
+    table->scope_capacity = 16;
+    table->scope_starts = (int *)region_alloc(REGION_SYMBOLS, table->scope_capacity * sizeof(int));
     table->scope_level = 0;
-    table->symbols = (Symbol **)calloc(size, sizeof(Symbol *));
     return table;
 }
 
-bool symbol_table_insert(SymbolTable *table, const char *name, SymbolType sym_type, DataType data_type)
+bool symbol_table_insert(SymbolTable *table, NameId name, SymbolType sym_type, DataType data_type)
 {
-    unsigned int index = hash(name, table->size);
-    Symbol *current = table->symbols[index];
-    while (current != NULL)
+    // Keep the load factor at or below three quarters
+    if ((table->used + 1) * 4 > table->capacity * 3)
+        grow_slots(table);
+
+    SymbolSlot *slot = find_slot(table, name);
+    if (slot->name == NAME_NONE)
     {
-        if (strcmp(current->name, name) == 0 && current->scope_level == table->scope_level)
-        {
-            return false;
-        }
-        current = current->next;
+        slot->name = name;
+        slot->symbol = -1;
+        table->used++;
+    }
+    else if (slot->symbol >= 0 && table->symbols[slot->symbol].scope_level == table->scope_level)
+    {
+        return false;
     }
-    Symbol *symbol = (Symbol *)malloc(sizeof(Symbol));
-    symbol->name = strdup(name);
+
+    if (table->symbol_count >= table->symbol_capacity)
+    {
+        table->symbols = (Symbol *)region_grow(REGION_SYMBOLS, table->symbols,
+                                               table->symbol_capacity * sizeof(Symbol),
+                                               table->symbol_capacity * 2 * sizeof(Symbol));
+        table->symbol_capacity *= 2;
+    }
+
+    int index = table->symbol_count++;
+    Symbol *symbol = &table->symbols[index];
+    symbol->name = name;
     symbol->symbol_type = sym_type;
     symbol->data_type = data_type;
     symbol->is_initialized = false;
     symbol->scope_level = table->scope_level;
-    symbol->next = table->symbols[index];
-    table->symbols[index] = symbol;
+    symbol->shadowed = slot->symbol;
+    symbol->slot = SLOT_NONE;
+    slot->symbol = index;
 
     return true;
 }
 
-Symbol *symbol_table_lookup(SymbolTable *table, const char *name)
+// The slot always points at the innermost binding, so lookup is a single probe sequence
+Symbol *symbol_table_lookup(SymbolTable *table, NameId name)
 {
-    unsigned int index = hash(name, table->size);
-    Symbol *current = table->symbols[index];
-    Symbol *found = NULL;
-    while (current != NULL)
-    {
-        if (strcmp(current->name, name) == 0 &&
-            (found == NULL || current->scope_level > found->scope_level))
-        {
-            found = current;
-        }
-        current = current->next;
-    }
-
-    return found;
+    SymbolSlot *slot = find_slot(table, name);
+    if (slot->name == NAME_NONE || slot->symbol < 0)
+        return NULL;
+    return &table->symbols[slot->symbol];
 }
 
 void symbol_table_enter_scope(SymbolTable *table)
 {
+    if (table->scope_level >= table->scope_capacity)
+    {
+        table->scope_starts = (int *)region_grow(REGION_SYMBOLS, table->scope_starts,
+                                                 table->scope_capacity * sizeof(int),
+                                                 table->scope_capacity * 2 * sizeof(int));
+        table->scope_capacity *= 2;
+    }
+    table->scope_starts[table->scope_level] = table->symbol_count;
     table->scope_level++;
 }
 
+// Pop the scope's declarations newest first, restoring whatever each one shadowed
 void symbol_table_exit_scope(SymbolTable *table)
 {
-    for (int i = 0; i < table->size; i++)
-    {
-        Symbol *current = table->symbols[i];
-        Symbol *prev = NULL;
-
-        while (current != NULL)
-        {
-            if (current->scope_level == table->scope_level)
-            {
-                Symbol *to_delete = current;
-
-                if (prev == NULL)
-                {
-                    table->symbols[i] = current->next;
-                }
-                else
-                {
-                    prev->next = current->next;
-                }
-
-                current = current->next;
-                free(to_delete->name);
-                free(to_delete);
-            }
-            else
-            {
-                prev = current;
-                current = current->next;
-            }
-        }
-    }
+    if (table->scope_level == 0)
+        return;
 
     table->scope_level--;
+    int start = table->scope_starts[table->scope_level];
+    while (table->symbol_count > start)
+    {
+        Symbol *symbol = &table->symbols[--table->symbol_count];
+        find_slot(table, symbol->name)->symbol = symbol->shadowed;
+    }
 }
 
-void symbol_table_set_initialized(SymbolTable *table, const char *name)
+void symbol_table_set_initialized(SymbolTable *table, NameId name)
 {
     Symbol *symbol = symbol_table_lookup(table, name);
     if (symbol)
@@ -117,26 +148,6 @@ void symbol_table_set_initialized(SymbolTable *table, const char *name)
     }
 }
 
-void free_symbol_table(SymbolTable *table)
-{
-    if (!table)
-        return;
-
-    for (int i = 0; i < table->size; i++)
-    {
-        Symbol *current = table->symbols[i];
-        while (current != NULL)
-        {
-            Symbol *next = current->next;
-            free(current->name);
-            free(current);
-            current = next;
-        }
-    }
-    free(table->symbols);
-    free(table);
-}
-
 // function to print symbol table contents
 void print_symbol_table(SymbolTable *table)
 {
@@ -147,19 +158,86 @@ void print_symbol_table(SymbolTable *table)
            "Name", "Type", "DataType", "Scope", "Initialized");
     printf("--------------------------------------------------------\n");
 
-    for (int i = 0; i < table->size; i++)
+    for (int i = 0; i < table->symbol_count; i++)
     {
-        Symbol *current = table->symbols[i];
-        while (current != NULL)
+        Symbol *current = &table->symbols[i];
+        const char *sym_type = current->symbol_type == SYMBOL_VARIABLE ? "Variable" : "Function";
+        const char *data_type = current->data_type == TYPE_NUM ? "num" : current->data_type == TYPE_STR ? "str": "void";
+        printf("%-20s %-10s %-10s %-10d %s\n",
+               name_str(current->name), sym_type, data_type,
+               current->scope_level,
+               current->is_initialized ? "Yes" : "No");
+    }
+    printf("--------------------------------------------------------\n");
+}
+
+SlotTable *create_slot_table(void)
+{
+    SlotTable *slots = (SlotTable *)region_alloc(REGION_IR, sizeof(SlotTable));
+    slots->capacity = 16;
+    slots->slots = (VarSlot *)region_calloc(REGION_IR, slots->capacity, sizeof(VarSlot));
+    slots->count = 1;
+    slots->name_capacity = name_count();
+    slots->by_name = (SlotId *)region_calloc(REGION_IR, slots->name_capacity, sizeof(SlotId));
+    return slots;
+}
+
+// Pick a label no identifier in the program uses. Every identifier has been
+// interned by the parser, so a candidate that is not interned yet is free.
+static NameId unique_label(NameId name)
+{
+    char label[256];
+    for (int n = 1;; n++)
+    {
+        int length = snprintf(label, sizeof(label), "%s_%d", name_str(name), n);
+        if (intern_find(label, length) == NAME_NONE)
+            return intern(label, length);
+    }
+}
+
+// Give a new declaration its storage, reusing a dead slot of the same name and type
+SlotId slot_table_bind(SlotTable *slots, NameId name, DataType type)
+{
+    if (name >= slots->name_capacity)
+    {
+        uint32_t capacity = name_count();
+        slots->by_name = (SlotId *)region_grow(REGION_IR, slots->by_name,
+                                               slots->name_capacity * sizeof(SlotId),
+                                               capacity * sizeof(SlotId));
+        memset(slots->by_name + slots->name_capacity, 0, (capacity - slots->name_capacity) * sizeof(SlotId));
+        slots->name_capacity = capacity;
+    }
+
+    for (SlotId id = slots->by_name[name]; id != SLOT_NONE; id = slots->slots[id].next_same_name)
+    {
+        if (!slots->slots[id].live && slots->slots[id].type == type)
         {
-            const char *sym_type = current->symbol_type == SYMBOL_VARIABLE ? "Variable" : "Function";
-            const char *data_type = current->data_type == TYPE_NUM ? "num" : current->data_type == TYPE_STR ? "str": "void";
-            printf("%-20s %-10s %-10s %-10d %s\n",
-                   current->name, sym_type, data_type,
-                   current->scope_level,
-                   current->is_initialized ? "Yes" : "No");
-            current = current->next;
+            slots->slots[id].live = true;
+            return id;
         }
     }
-    printf("--------------------------------------------------------\n");
+
+    if (slots->count >= slots->capacity)
+    {
+        slots->slots = (VarSlot *)region_grow(REGION_IR, slots->slots,
+                                              slots->capacity * sizeof(VarSlot),
+                                              slots->capacity * 2 * sizeof(VarSlot));
+        slots->capacity *= 2;
+    }
+
+    SlotId id = slots->count++;
+    VarSlot *slot = &slots->slots[id];
+    slot->name = name;
+    slot->label = slots->by_name[name] == SLOT_NONE ? name : unique_label(name);
+    slot->type = type;
+    slot->live = true;
+    slot->next_same_name = slots->by_name[name];
+    slots->by_name[name] = id;
+    return id;
+}
+
+void slot_table_release(SlotTable *slots, SlotId slot)
+{
+    if (slot != SLOT_NONE)
+        slots->slots[slot].live = false;
 }
\ No newline at end of file
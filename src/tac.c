@@ -1,593 +1,480 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdarg.h>
 #include "../include/tac.h"
 
-static int temp_counter = 0;
-static int label_counter = 0;
+#define INITIAL_TAC_CAPACITY 256
 
-// Create a new TAC instruction
-TAC *tac_create(TACOpType op, char *result, char *arg1, char *arg2, int line)
+TacBuffer *create_tac_buffer(SlotTable *slots)
 {
-    TAC *tac = (TAC *)malloc(sizeof(TAC));
-    if (!tac)
+    TacBuffer *buffer = (TacBuffer *)region_alloc(REGION_IR, sizeof(TacBuffer));
+    buffer->capacity = INITIAL_TAC_CAPACITY;
+    buffer->count = 0;
+    buffer->code = (TAC *)region_alloc(REGION_IR, buffer->capacity * sizeof(TAC));
+    buffer->temp_count = 0;
+    buffer->label_count = 0;
+    buffer->slots = slots;
+    return buffer;
+}
+
+// Append an instruction; the returned pointer is only valid until the next emit
+TAC *tac_emit(TacBuffer *buffer, TACOpType op, Operand result, Operand arg1, Operand arg2, uint32_t offset)
+{
+    if (buffer->count >= buffer->capacity)
     {
-        fprintf(stderr, "Error: Memory allocation failed for TAC\n");
-        exit(1);
+        buffer->code = (TAC *)region_grow(REGION_IR, buffer->code,
+                                          buffer->capacity * sizeof(TAC),
+                                          buffer->capacity * 2 * sizeof(TAC));
+        buffer->capacity *= 2;
     }
 
+    TAC *tac = &buffer->code[buffer->count++];
     tac->op = op;
-    tac->result = result ? strdup(result) : NULL;
-    tac->arg1 = arg1 ? strdup(arg1) : NULL;
-    tac->arg2 = arg2 ? strdup(arg2) : NULL;
-    tac->next = NULL;
-    tac->line = line;
+    tac->result = result;
+    tac->arg1 = arg1;
+    tac->arg2 = arg2;
+    tac->offset = offset;
+    tac->type = TYPE_NUM;
     return tac;
 }
 
-// Free a TAC instruction
-void tac_free(TAC *tac)
+// Temps and labels are plain numbers; the code generator names them
+Operand generate_temp_var(TacBuffer *out)
 {
-    if (!tac)
-        return;
-
-    free(tac->result);
-    free(tac->arg1);
-    free(tac->arg2);
-    free(tac);
+    return make_operand(OPERAND_TEMP, out->temp_count++);
 }
 
-// Join two TAC lists
-TAC *tac_join(TAC *tac1, TAC *tac2)
+Operand generate_label(TacBuffer *out)
 {
-    if (!tac1)
-        return tac2;
-    if (!tac2)
-        return tac1;
+    return make_operand(OPERAND_LABEL, out->label_count++);
+}
 
-    TAC *current = tac1;
-    while (current->next)
+// Variables are referred to by their storage slot. Trees that have not been
+// through semantic analysis get one slot per name.
+static Operand variable_operand(TacBuffer *out, SlotId slot, NameId name)
+{
+    if (slot == SLOT_NONE)
     {
-        current = current->next;
+        if (name < out->slots->name_capacity)
+            slot = out->slots->by_name[name];
+        if (slot == SLOT_NONE)
+            slot = slot_table_bind(out->slots, name, TYPE_NUM);
     }
-    current->next = tac2;
-    return tac1;
+    return make_operand(OPERAND_VAR, slot);
 }
 
-// Generate a unique temporary variable name
-char *generate_temp_var(void)
+// Text being built by format_tac; output past the end is dropped
+typedef struct
 {
-    char *temp = (char *)malloc(64);
-    if (!temp)
-    {
-        fprintf(stderr, "Error: Memory allocation failed for temp var\n");
-        exit(1);
-    }
-    sprintf(temp, "t%d", temp_counter++);
-    return temp;
+    char *buffer;
+    size_t size;
+    size_t length;
+} TacText;
+
+static void text_append(TacText *text, const char *format, ...)
+{
+    if (text->length + 1 >= text->size)
+        return;
+
+    va_list args;
+    va_start(args, format);
+    int written = vsnprintf(text->buffer + text->length, text->size - text->length, format, args);
+    va_end(args);
+
+    if (written > 0)
+        text->length += (size_t)written;
+    if (text->length >= text->size)
+        text->length = text->size - 1;
 }
 
-// Generate a unique label
-char *generate_label(void)
+static void append_operand(TacText *text, Operand operand, const SlotTable *slots)
 {
-    char *label = (char *)malloc(32);
-    if (!label)
+    switch (operand.kind)
     {
-        fprintf(stderr, "Error: Memory allocation failed for label\n");
-        exit(1);
+    case OPERAND_TEMP:
+        text_append(text, "t%u", operand.id);
+        break;
+    case OPERAND_VAR:
+        text_append(text, "%s", name_str(slots->slots[operand.id].label));
+        break;
+    case OPERAND_IMM:
+        text_append(text, "%lld", (long long)operand.imm);
+        break;
+    case OPERAND_STRING:
+        text_append(text, "\"%s\"", name_str(operand.id));
+        break;
+    case OPERAND_LABEL:
+        text_append(text, "L%u", operand.id);
+        break;
+    case OPERAND_FUNC:
+        text_append(text, "%s", name_str(operand.id));
+        break;
+    case OPERAND_NONE:
+        break;
     }
-    sprintf(label, "L%d", label_counter++);
-    return label;
 }
 
-void reset_temp_counter(void)
+// Appends prefix, operand, suffix
+static void append_part(TacText *text, const char *prefix, Operand operand, const SlotTable *slots, const char *suffix)
 {
-    temp_counter = 0;
+    text_append(text, "%s", prefix);
+    append_operand(text, operand, slots);
+    text_append(text, "%s", suffix);
 }
-void reset_label_counter(void)
+
+static void append_binary(TacText *text, const TAC *tac, const SlotTable *slots, const char *op)
 {
-    label_counter = 0;
+    append_operand(text, tac->result, slots);
+    append_part(text, " = ", tac->arg1, slots, "");
+    text_append(text, " %s ", op);
+    append_operand(text, tac->arg2, slots);
 }
 
-void print_tac(TAC *tac)
+// One instruction as text, without a newline; returns its length
+size_t format_tac(char *buffer, size_t size, const TAC *tac, const SlotTable *slots)
 {
-    if (!tac)
-        return;
+    TacText text = {buffer, size, 0};
+    if (size == 0)
+        return 0;
+    buffer[0] = '\0';
 
     switch (tac->op)
     {
     case TAC_ASSIGN:
-        printf("%s = %s\n", tac->result, tac->arg1);
+        append_operand(&text, tac->result, slots);
+        append_part(&text, " = ", tac->arg1, slots, "");
         break;
     case TAC_ADD:
-        printf("%s = %s + %s\n", tac->result, tac->arg1, tac->arg2);
+        append_binary(&text, tac, slots, "+");
         break;
     case TAC_SUB:
-        printf("%s = %s - %s\n", tac->result, tac->arg1, tac->arg2);
+        append_binary(&text, tac, slots, "-");
         break;
     case TAC_MUL:
-        printf("%s = %s * %s\n", tac->result, tac->arg1, tac->arg2);
+        append_binary(&text, tac, slots, "*");
         break;
     case TAC_DIV:
-        printf("%s = %s / %s\n", tac->result, tac->arg1, tac->arg2);
+        append_binary(&text, tac, slots, "/");
         break;
     case TAC_MOD:
-        printf("%s = %s %% %s\n", tac->result, tac->arg1, tac->arg2);
+        append_binary(&text, tac, slots, "%");
         break;
     case TAC_NEG:
-        printf("%s = -%s\n", tac->result, tac->arg1);
+        append_operand(&text, tac->result, slots);
+        append_part(&text, " = -", tac->arg1, slots, "");
         break;
     case TAC_LABEL:
-        printf("%s:\n", tac->result);
+        append_part(&text, "", tac->result, slots, ":");
         break;
     case TAC_IF:
-        printf("if %s goto %s\n", tac->arg1, tac->result);
+        append_part(&text, "if ", tac->arg1, slots, "");
+        append_part(&text, " goto ", tac->result, slots, "");
         break;
     case TAC_GOTO:
-        printf("goto %s\n", tac->result);
+        append_part(&text, "goto ", tac->result, slots, "");
         break;
     case TAC_RETURN:
-        printf("return %s\n", tac->result);
+        append_part(&text, "return ", tac->result, slots, "");
         break;
     case TAC_FUNC_START:
-        printf("function %s start\n", tac->result);
+        append_part(&text, "function ", tac->result, slots, " start");
         break;
     case TAC_FUNC_END:
-        printf("function %s end\n", tac->result);
+        append_part(&text, "function ", tac->result, slots, " end");
         break;
     case TAC_PARAM:
-        printf("param %s\n", tac->result);
+        append_part(&text, "param ", tac->result, slots, "");
         break;
     case TAC_CALL:
-        printf("%s = call %s, %s\n", tac->result, tac->arg1, tac->arg2);
+        if (tac->result.kind != OPERAND_NONE)
+            append_part(&text, "", tac->result, slots, " = ");
+        append_part(&text, "call ", tac->arg1, slots, "");
+        append_part(&text, ", ", tac->arg2, slots, "");
         break;
     case TAC_ARG:
-        printf("arg %s\n", tac->result);
+        append_part(&text, "arg ", tac->result, slots, "");
         break;
     case TAC_VAR:
-        printf("var %s\n", tac->result);
+        append_part(&text, "var ", tac->result, slots, "");
         break;
     case TAC_ARRAY:
-        printf("%s = %s[%s]\n", tac->result, tac->arg1, tac->arg2);
+        append_part(&text, "", tac->result, slots, " = ");
+        append_operand(&text, tac->arg1, slots);
+        append_part(&text, "[", tac->arg2, slots, "]");
         break;
     case TAC_LOAD:
-        printf("%s = *%s\n", tac->result, tac->arg1);
+        append_operand(&text, tac->result, slots);
+        append_part(&text, " = *", tac->arg1, slots, "");
         break;
     case TAC_STORE:
-        printf("*%s = %s\n", tac->result, tac->arg1);
+        append_part(&text, "*", tac->result, slots, "");
+        append_part(&text, " = ", tac->arg1, slots, "");
         break;
     case TAC_LESS:
-        printf("%s = %s < %s\n", tac->result, tac->arg1, tac->arg2);
+        append_binary(&text, tac, slots, "<");
+        break;
+    case TAC_LESS_EQ:
+        append_binary(&text, tac, slots, "<=");
         break;
     case TAC_GREATER:
-        printf("%s = %s > %s\n", tac->result, tac->arg1, tac->arg2);
+        append_binary(&text, tac, slots, ">");
+        break;
+    case TAC_GREATER_EQ:
+        append_binary(&text, tac, slots, ">=");
         break;
+    case TAC_EQ:
+        append_binary(&text, tac, slots, "==");
+        break;
+    case TAC_NEQ:
+        append_binary(&text, tac, slots, "!=");
+        break;
+    case TAC_NOP:
+        break;
+    }
+    return text.length;
+}
+
+void print_tac(const TAC *tac, const SlotTable *slots)
+{
+    char text[TAC_TEXT_SIZE];
+    if (!tac || tac->op == TAC_NOP)
+        return;
+
+    format_tac(text, sizeof(text), tac, slots);
+    printf("%s\n", text);
+}
+
+void print_tac_list(const TacBuffer *tac)
+{
+    for (int i = 0; i < tac->count; i++)
+    {
+        print_tac(&tac->code[i], tac->slots);
     }
 }
-void print_tac_list(TAC *tac)
+
+static TACOpType binary_tac_op(BinaryOpType op)
 {
-    while (tac)
+    switch (op)
     {
-        print_tac(tac);
-        tac = tac->next;
+    case OP_ADD:
+        return TAC_ADD;
+    case OP_SUBTRACT:
+        return TAC_SUB;
+    case OP_MULTIPLY:
+        return TAC_MUL;
+    case OP_DIVIDE:
+        return TAC_DIV;
+    case OP_LESS:
+        return TAC_LESS;
+    case OP_GREATER:
+        return TAC_GREATER;
+    default:
+        return TAC_ASSIGN;
     }
 }
-TAC *generate_tac_for_expr(Node *node)
+
+// Emit the code for an expression and return the operand that holds its value
+Operand generate_tac_for_expr(TacBuffer *out, const Ast *ast, NodeId id)
 {
-    if (!node)
-        return NULL;
+    if (!id)
+        return NO_OPERAND;
 
+    const Node *node = ast_node(ast, id);
     switch (node->type)
     {
     case NODE_NUMBER:
     {
-        char value_str[32];
-        sprintf(value_str, "%d", node->number.value);
-        return tac_create(TAC_ASSIGN, generate_temp_var(), strdup(value_str), NULL, node->number.info.line);
+        Operand temp = generate_temp_var(out);
+        tac_emit(out, TAC_ASSIGN, temp, make_imm(node->number), NO_OPERAND, node->offset);
+        return temp;
     }
 
     case NODE_STRING:
     {
-        char *quoted_str = (char *)malloc(strlen(node->string.value) + 3);
-        if (!quoted_str)
-        {
-            fprintf(stderr, "Error: Memory allocation failed for quoted string\n");
-            exit(1);
-        }
-        sprintf(quoted_str, "\"%s\"", node->string.value);
-        TAC *result = tac_create(TAC_ASSIGN, generate_temp_var(), quoted_str, NULL, node->string.info.line);
-        free(quoted_str);
-        return result;
+        Operand temp = generate_temp_var(out);
+        tac_emit(out, TAC_ASSIGN, temp, make_operand(OPERAND_STRING, node->string), NO_OPERAND, node->offset)->type = TYPE_STR;
+        return temp;
     }
 
     case NODE_BINARY_OP:
     {
-        TAC *left = generate_tac_for_expr(node->binary_op.left);
-        TAC *right = generate_tac_for_expr(node->binary_op.right);
+        if (node->op == OP_ASSIGN)
+        {
+            // The target is only written, so it is not evaluated as a value first
+            const Node *target = ast_node(ast, node->binary_op.left);
+            if (target->type != NODE_IDENTIFIER)
+                return NO_OPERAND;
+
+            Operand storage = variable_operand(out, target->identifier.slot, target->identifier.name);
+            Operand value = generate_tac_for_expr(out, ast, node->binary_op.right);
+            if (value.kind == OPERAND_NONE)
+                return NO_OPERAND;
+
+            tac_emit(out, TAC_ASSIGN, storage, value, NO_OPERAND, node->offset)->type =
+                ast_node(ast, node->binary_op.right)->data_type;
+            return storage;
+        }
 
-        if (!left || !right)
-            return NULL;
+        TACOpType op = binary_tac_op(node->op);
+        if (op == TAC_ASSIGN)
+            return NO_OPERAND;
 
-        TAC *last_left = left;
-        while (last_left->next)
-            last_left = last_left->next;
+        Operand left = generate_tac_for_expr(out, ast, node->binary_op.left);
+        Operand right = generate_tac_for_expr(out, ast, node->binary_op.right);
+        if (left.kind == OPERAND_NONE || right.kind == OPERAND_NONE)
+            return NO_OPERAND;
 
-        TAC *last_right = right;
-        while (last_right->next)
-            last_right = last_right->next;
+        Operand temp = generate_temp_var(out);
+        tac_emit(out, op, temp, left, right, node->offset);
+        return temp;
+    }
 
-        TAC *result = NULL;
-        switch (node->binary_op.op)
-        {
-        case OP_ADD:
-        case OP_SUBTRACT:
-        case OP_MULTIPLY:
-        case OP_DIVIDE:
-        case OP_LESS:
-        case OP_GREATER:
+    case NODE_IDENTIFIER:
+    {
+        Operand storage = variable_operand(out, node->identifier.slot, node->identifier.name);
+        Operand temp = generate_temp_var(out);
+        tac_emit(out, TAC_ASSIGN, temp, storage, NO_OPERAND, node->offset)->type = node->data_type;
+        return temp;
+    }
+
+    case NODE_FUNCTION_CALL:
+    {
+        Operand arg_result = NO_OPERAND;
+        DataType arg_type = TYPE_VOID;
+        for (uint32_t i = 0; i < node->function_call.arguments.count; i++)
         {
-            char *temp = generate_temp_var();
-            switch (node->binary_op.op)
+            NodeId arg = ast_child(ast, node->function_call.arguments, i);
+            Operand value = generate_tac_for_expr(out, ast, arg);
+            if (value.kind != OPERAND_NONE)
             {
-            case OP_ADD:
-                result = tac_create(TAC_ADD, temp, last_left->result, last_right->result, node->binary_op.info.line);
-                break;
-            case OP_SUBTRACT:
-                result = tac_create(TAC_SUB, temp, last_left->result, last_right->result, node->binary_op.info.line);
-                break;
-            case OP_MULTIPLY:
-                result = tac_create(TAC_MUL, temp, last_left->result, last_right->result, node->binary_op.info.line);
-                break;
-            case OP_DIVIDE:
-                result = tac_create(TAC_DIV, temp, last_left->result, last_right->result, node->binary_op.info.line);
-                break;
-            case OP_LESS:
-                result = tac_create(TAC_LESS, temp, last_left->result, last_right->result, node->binary_op.info.line);
-                break;
-            case OP_GREATER:
-                result = tac_create(TAC_GREATER, temp, last_left->result, last_right->result, node->binary_op.info.line);
-                break;
-            default:
-                free(temp);
-                return NULL;
+                arg_result = value;
+                arg_type = ast_node(ast, arg)->data_type;
             }
-            break;
-        }
-        case OP_ASSIGN:
-            if (node->binary_op.left->type == NODE_IDENTIFIER)
-            {
-                result = tac_create(TAC_ASSIGN, strdup(node->binary_op.left->identifier.name), last_right->result, NULL, node->binary_op.info.line);
-            }
-            break;
-        default:
-            return NULL;
         }
 
-        TAC *joined = tac_join(left, right);
-        if (result)
+        Operand callee = make_operand(OPERAND_FUNC, node->function_call.name);
+        if (node->function_call.name == NAME_SHOW)
         {
-            joined = tac_join(joined, result);
+            // The call carries its argument's type
+            tac_emit(out, TAC_CALL, NO_OPERAND, callee, arg_result, node->offset)->type = arg_type;
+            return NO_OPERAND;
         }
-        return joined;
-    }
 
-    case NODE_IDENTIFIER:
-        return tac_create(TAC_ASSIGN, generate_temp_var(), strdup(node->identifier.name), NULL, node->identifier.info.line);
+        Operand temp = generate_temp_var(out);
+        TAC *call = tac_emit(out, TAC_CALL, temp, callee, arg_result, node->offset);
+        call->type = node->function_call.name == NAME_ASK ? TYPE_STR : node->data_type;
+        return temp;
+    }
 
     default:
-        return NULL;
+        return NO_OPERAND;
     }
 }
 
-// Generate TAC for statements
-TAC *generate_tac_for_stmt(Node *node)
+// Emit the code for a statement
+void generate_tac_for_stmt(TacBuffer *out, const Ast *ast, NodeId id)
 {
-    if (!node)
-        return NULL;
+    if (!id)
+        return;
 
+    const Node *node = ast_node(ast, id);
     switch (node->type)
     {
     case NODE_VARIABLE_DECLARATION:
     {
-        if (node->var_decl.initializer)
-        {
-            TAC *init = NULL;
-            if (node->var_decl.initializer->type == NODE_FUNCTION_CALL)
-            {
-                init = generate_tac_for_stmt(node->var_decl.initializer);
-            }
-            else
-            {
-                init = generate_tac_for_expr(node->var_decl.initializer);
-            }
+        if (!node->var_decl.initializer)
+            return;
 
-            if (init)
-            {
-                TAC *last_tac = init;
-                while (last_tac->next)
-                {
-                    last_tac = last_tac->next;
-                }
-                TAC *assign = tac_create(TAC_ASSIGN, strdup(node->var_decl.name), last_tac->result, NULL, node->var_decl.info.line);
-
-                TAC *result = tac_join(init, assign);
-                return result;
-            }
+        Operand storage = variable_operand(out, node->var_decl.slot, node->var_decl.name);
+        Operand value = generate_tac_for_expr(out, ast, node->var_decl.initializer);
+        if (value.kind != OPERAND_NONE)
+        {
+            tac_emit(out, TAC_ASSIGN, storage, value, NO_OPERAND, node->offset)->type =
+                ast_node(ast, node->var_decl.initializer)->data_type;
         }
-        return NULL;
+        return;
     }
 
     case NODE_FOR_LOOP:
     {
-        TAC *init = generate_tac_for_stmt(node->for_loop.initializer);
-        if (!init)
-            return NULL;
-
-        char *start_label = generate_label();
-        char *body_label = generate_label();
-        char *end_label = generate_label();
-
-        TAC *condition = generate_tac_for_expr(node->for_loop.condition);
-        if (!condition)
-        {
-            free(start_label);
-            free(body_label);
-            free(end_label);
-            return NULL;
-        }
-
-        TAC *last_tac = condition;
-        while (last_tac->next)
-        {
-            last_tac = last_tac->next;
-        }
-
-        TAC *start_label_tac = tac_create(TAC_LABEL, start_label, NULL, NULL, node->for_loop.info.line);
-        TAC *if_body = tac_create(TAC_IF, body_label, last_tac->result, NULL, node->for_loop.info.line);
-        TAC *goto_end = tac_create(TAC_GOTO, end_label, NULL, NULL, node->for_loop.info.line);
-        TAC *body_label_tac = tac_create(TAC_LABEL, body_label, NULL, NULL, node->for_loop.info.line);
-
-        TAC *body = generate_tac_for_stmt(node->for_loop.body);
-        if (!body)
-        {
-            tac_free(init);
-            tac_free(condition);
-            tac_free(start_label_tac);
-            tac_free(if_body);
-            tac_free(goto_end);
-            tac_free(body_label_tac);
-            free(start_label);
-            free(body_label);
-            free(end_label);
-            return NULL;
-        }
-
-        TAC *increment = generate_tac_for_expr(node->for_loop.increment);
-        if (!increment)
-        {
-            tac_free(init);
-            tac_free(condition);
-            tac_free(start_label_tac);
-            tac_free(if_body);
-            tac_free(goto_end);
-            tac_free(body_label_tac);
-            tac_free(body);
-            free(start_label);
-            free(body_label);
-            free(end_label);
-            return NULL;
-        }
-
-        TAC *goto_start = tac_create(TAC_GOTO, start_label, NULL, NULL, node->for_loop.info.line);
-        TAC *end_label_tac = tac_create(TAC_LABEL, end_label, NULL, NULL, node->for_loop.info.line);
-
-        TAC *result = init;
-        result = tac_join(result, start_label_tac);
-        result = tac_join(result, condition);
-        result = tac_join(result, if_body);
-        result = tac_join(result, goto_end);
-        result = tac_join(result, body_label_tac);
-        result = tac_join(result, body);
-        result = tac_join(result, increment);
-        result = tac_join(result, goto_start);
-        result = tac_join(result, end_label_tac);
-        return result;
+        generate_tac_for_stmt(out, ast, node->for_loop.initializer);
+
+        Operand start_label = generate_label(out);
+        Operand body_label = generate_label(out);
+        Operand end_label = generate_label(out);
+
+        tac_emit(out, TAC_LABEL, start_label, NO_OPERAND, NO_OPERAND, node->offset);
+        Operand condition = generate_tac_for_expr(out, ast, node->for_loop.condition);
+        tac_emit(out, TAC_IF, body_label, condition, NO_OPERAND, node->offset);
+        tac_emit(out, TAC_GOTO, end_label, NO_OPERAND, NO_OPERAND, node->offset);
+        tac_emit(out, TAC_LABEL, body_label, NO_OPERAND, NO_OPERAND, node->offset);
+        generate_tac_for_stmt(out, ast, node->for_loop.body);
+        generate_tac_for_expr(out, ast, node->for_loop.increment);
+        tac_emit(out, TAC_GOTO, start_label, NO_OPERAND, NO_OPERAND, node->offset);
+        tac_emit(out, TAC_LABEL, end_label, NO_OPERAND, NO_OPERAND, node->offset);
+        return;
     }
 
     case NODE_IF_STATEMENT:
     {
-        TAC *condition = generate_tac_for_expr(node->if_stmt.condition);
-        if (!condition)
-            return NULL;
-
-        char *true_label = generate_label();
-        char *false_label = generate_label();
-        char *end_label = generate_label();
-        TAC *last_tac = condition;
-        while (last_tac->next)
-        {
-            last_tac = last_tac->next;
-        }
-
-        TAC *if_tac = tac_create(TAC_IF, true_label, last_tac->result, NULL, node->if_stmt.info.line);
-        TAC *goto_false = tac_create(TAC_GOTO, false_label, NULL, NULL, node->if_stmt.info.line);
-        TAC *true_label_tac = tac_create(TAC_LABEL, true_label, NULL, NULL, node->if_stmt.info.line);
-        TAC *body = generate_tac_for_stmt(node->if_stmt.if_body);
-        if (!body)
-        {
-            tac_free(condition);
-            tac_free(if_tac);
-            tac_free(goto_false);
-            tac_free(true_label_tac);
-            free(true_label);
-            free(false_label);
-            free(end_label);
-            return NULL;
-        }
-
-        TAC *goto_end = tac_create(TAC_GOTO, end_label, NULL, NULL, node->if_stmt.info.line);
-        TAC *false_label_tac = tac_create(TAC_LABEL, false_label, NULL, NULL, node->if_stmt.info.line);
-        TAC *else_body = NULL;
-        if (node->if_stmt.else_body)
-        {
-            else_body = generate_tac_for_stmt(node->if_stmt.else_body);
-            if (!else_body)
-            {
-                tac_free(condition);
-                tac_free(if_tac);
-                tac_free(goto_false);
-                tac_free(true_label_tac);
-                tac_free(body);
-                tac_free(goto_end);
-                tac_free(false_label_tac);
-                free(true_label);
-                free(false_label);
-                free(end_label);
-                return NULL;
-            }
-        }
-
-        TAC *end_label_tac = tac_create(TAC_LABEL, end_label, NULL, NULL, node->if_stmt.info.line);
-        TAC *result = condition;
-        result = tac_join(result, if_tac);
-        result = tac_join(result, goto_false);
-        result = tac_join(result, true_label_tac);
-        result = tac_join(result, body);
-        result = tac_join(result, goto_end);
-        result = tac_join(result, false_label_tac);
-        if (else_body)
-        {
-            result = tac_join(result, else_body);
-        }
-        result = tac_join(result, end_label_tac);
-        return result;
+        Operand condition = generate_tac_for_expr(out, ast, node->if_stmt.condition);
+
+        Operand true_label = generate_label(out);
+        Operand false_label = generate_label(out);
+        Operand end_label = generate_label(out);
+
+        tac_emit(out, TAC_IF, true_label, condition, NO_OPERAND, node->offset);
+        tac_emit(out, TAC_GOTO, false_label, NO_OPERAND, NO_OPERAND, node->offset);
+        tac_emit(out, TAC_LABEL, true_label, NO_OPERAND, NO_OPERAND, node->offset);
+        generate_tac_for_stmt(out, ast, node->if_stmt.if_body);
+        tac_emit(out, TAC_GOTO, end_label, NO_OPERAND, NO_OPERAND, node->offset);
+        tac_emit(out, TAC_LABEL, false_label, NO_OPERAND, NO_OPERAND, node->offset);
+        generate_tac_for_stmt(out, ast, node->if_stmt.else_body);
+        tac_emit(out, TAC_LABEL, end_label, NO_OPERAND, NO_OPERAND, node->offset);
+        return;
     }
 
     case NODE_BLOCK:
     case NODE_PROGRAM:
     {
-        TAC *result = NULL;
-        for (int i = 0; i < node->block.count; i++)
-        {
-            TAC *stmt = generate_tac_for_stmt(node->block.statements[i]);
-            if (stmt)
-            {
-                if (!result)
-                {
-                    result = stmt;
-                }
-                else
-                {
-                    result = tac_join(result, stmt);
-                }
-            }
-        }
-        return result;
-    }
-
-    case NODE_FUNCTION_CALL:
-    {
-        TAC *args = NULL;
-        TAC *last_arg = NULL;
-        for (int i = 0; i < node->function_call.arg_count; i++)
-        {
-            TAC *arg = generate_tac_for_expr(node->function_call.arguments[i]);
-            if (arg)
-            {
-                if (!args)
-                {
-                    args = arg;
-                    last_arg = arg;
-                }
-                else
-                {
-                    TAC *new_last = tac_join(last_arg, arg);
-                    if (new_last != last_arg)
-                    {
-                        tac_free(last_arg);
-                    }
-                    last_arg = new_last;
-                }
-            }
-        }
-        char *arg_result = NULL;
-        if (last_arg)
+        for (uint32_t i = 0; i < node->block.count; i++)
         {
-            TAC *temp = last_arg;
-            while (temp->next)
-            {
-                temp = temp->next;
-            }
-            arg_result = temp->result;
-        }
-        if (strcmp(node->function_call.name, "show") == 0)
-        {
-            TAC *call = tac_create(TAC_CALL, NULL, strdup(node->function_call.name),
-                                   arg_result, node->function_call.info.line);
-            if (!call)
-            {
-                tac_free(args);
-                return NULL;
-            }
-            return tac_join(args, call);
-        }
-        else if (strcmp(node->function_call.name, "ask") == 0)
-        {
-            char *temp = generate_temp_var();
-            TAC *call = tac_create(TAC_CALL, temp, strdup(node->function_call.name),
-                                   arg_result, node->function_call.info.line);
-            if (!call)
-            {
-                free(temp);
-                tac_free(args);
-                return NULL;
-            }
-            return tac_join(args, call);
-        }
-        else
-        {
-            char *temp = generate_temp_var();
-            TAC *call = tac_create(TAC_CALL, temp, strdup(node->function_call.name),
-                                   arg_result, node->function_call.info.line);
-            if (!call)
-            {
-                free(temp);
-                tac_free(args);
-                return NULL;
-            }
-            return tac_join(args, call);
+            generate_tac_for_stmt(out, ast, ast_child(ast, node->block, i));
         }
+        return;
     }
 
     default:
-        return generate_tac_for_expr(node);
+        generate_tac_for_expr(out, ast, id);
+        return;
     }
 }
 
 // Main AST to TAC conversion function
-TAC *ast_to_tac(Node *node)
+TacBuffer *ast_to_tac(const Ast *ast)
 {
-    if (!node)
+    if (!ast || !ast->root)
         return NULL;
 
-    reset_temp_counter();
-    reset_label_counter();
-    TAC *tac = generate_tac_for_stmt(node);
+    TacBuffer *tac = create_tac_buffer(ast->slots ? ast->slots : create_slot_table());
+    generate_tac_for_stmt(tac, ast, ast->root);
     return tac;
 }
 
 // Test function to demonstrate TAC generation and printing
 void test_tac_generation(void)
 {
-    Node *num1 = create_number_node(5, 1, 1);
-    Node *num2 = create_number_node(3, 1, 5);
-    Node *add = create_binary_op_node(OP_ADD, num1, num2, 1, 3);
-    Node *var = create_identifier_node("x", 1, 7);
-    Node *assign = create_binary_op_node(OP_ASSIGN, var, add, 1, 1);
-    TAC *tac = ast_to_tac(assign);
+    Ast *ast = create_ast();
+    NodeId num1 = create_number_node(ast, 5, 0);
+    NodeId num2 = create_number_node(ast, 3, 4);
+    NodeId add = create_binary_op_node(ast, OP_ADD, num1, num2, 2);
+    NodeId var = create_identifier_node(ast, intern_cstr("x"), 6);
+    ast->root = create_binary_op_node(ast, OP_ASSIGN, var, add, 0);
+    TacBuffer *tac = ast_to_tac(ast);
     printf("\nGenerated Three-Address Code:\n");
     printf("----------------------------\n");
     print_tac_list(tac);
-    free_node(assign);
-    tac_free(tac);
+    region_release(REGION_AST);
+    region_release(REGION_IR);
 }
\ No newline at end of file
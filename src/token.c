@@ -0,0 +1,72 @@
+#include <string.h>
+#include "../include/token.h"
+
+// Display name and keyword spelling of every token type, indexed by TokenType
+const TokenInfo token_info[TOKEN_EOF + 1] = {
+    [TOKEN_NUM] = {"NUM", "num", 3},
+    [TOKEN_STR] = {"STR", "str", 3},
+    [TOKEN_PLUS] = {"PLUS", NULL, 0},
+    [TOKEN_MINUS] = {"MINUS", NULL, 0},
+    [TOKEN_MULTIPLY] = {"MULTIPLY", NULL, 0},
+    [TOKEN_DIVIDE] = {"DIVIDE", NULL, 0},
+    [TOKEN_LESS] = {"LESS", NULL, 0},
+    [TOKEN_GREATER] = {"GREATER", NULL, 0},
+    [TOKEN_SHOW] = {"SHOW", "show", 4},
+    [TOKEN_WHEN] = {"WHEN", "when", 4},
+    [TOKEN_OTHERWISE] = {"OTHERWISE", "otherwise", 9},
+    [TOKEN_REPEAT] = {"REPEAT", "repeat", 6},
+    [TOKEN_ASK] = {"ASK", "ask", 3},
+    [TOKEN_IDENTIFIER] = {"IDENTIFIER", NULL, 0},
+    [TOKEN_NUMBER_LITERAL] = {"NUMBER_LITERAL", NULL, 0},
+    [TOKEN_STRING_LITERAL] = {"STRING_LITERAL", NULL, 0},
+    [TOKEN_EQUALS] = {"EQUALS", NULL, 0},
+    [TOKEN_SEMICOLON] = {"SEMICOLON", NULL, 0},
+    [TOKEN_LPAREN] = {"LPAREN", NULL, 0},
+    [TOKEN_RPAREN] = {"RPAREN", NULL, 0},
+    [TOKEN_LBRACE] = {"LBRACE", NULL, 0},
+    [TOKEN_RBRACE] = {"RBRACE", NULL, 0},
+    [TOKEN_EOF] = {"EOF", NULL, 0},
+};
+
+// Perfect hash over the keyword set: (2 * length + first char) mod 16 gives every
+// keyword its own slot. Re-check the slots below whenever a keyword is added.
+#define KEYWORD_HASH(text, length) ((unsigned)((length) * 2 + (unsigned char)(text)[0]) & 15u)
+
+static const TokenType keyword_slots[16] = {
+    TOKEN_IDENTIFIER, // 0
+    TOKEN_OTHERWISE,  // 1
+    TOKEN_IDENTIFIER, // 2
+    TOKEN_IDENTIFIER, // 3
+    TOKEN_NUM,        // 4
+    TOKEN_IDENTIFIER, // 5
+    TOKEN_IDENTIFIER, // 6
+    TOKEN_ASK,        // 7
+    TOKEN_IDENTIFIER, // 8
+    TOKEN_STR,        // 9
+    TOKEN_IDENTIFIER, // 10
+    TOKEN_SHOW,       // 11
+    TOKEN_IDENTIFIER, // 12
+    TOKEN_IDENTIFIER, // 13
+    TOKEN_REPEAT,     // 14
+    TOKEN_WHEN,       // 15
+};
+
+// Classify an identifier span: one hash, one length check and one memcmp
+TokenType keyword_lookup(const char *text, int length)
+{
+    TokenType type = keyword_slots[KEYWORD_HASH(text, length)];
+    if (type == TOKEN_IDENTIFIER)
+        return TOKEN_IDENTIFIER;
+
+    if (token_info[type].keyword_length == length &&
+        memcmp(token_info[type].keyword, text, length) == 0)
+        return type;
+    return TOKEN_IDENTIFIER;
+}
+
+const char *token_type_to_string(TokenType type)
+{
+    if ((unsigned)type > TOKEN_EOF)
+        return "UNKNOWN";
+    return token_info[type].name;
+}
\ No newline at end of file
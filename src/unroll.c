@@ -0,0 +1,346 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../include/optimizer.h"
+#include "../include/cfg.h"
+
+// Loop unrolling for the shape a repeat loop lowers to:
+//
+//     start: t = i < n; if t goto body
+//            goto end
+//     body:  ... i = i + c; goto start
+//     end:
+//
+// with a constant limit n and i stepped once per iteration, at the end of the
+// body. When i also starts from a constant the trip count is known, and a loop
+// whose copies fit the budget is replaced by that many copies of its body.
+// Otherwise an unrolled loop runs factor copies per test while at least factor
+// iterations remain, and the original loop is kept after it for the remainder.
+// Only innermost loops are unrolled.
+
+typedef struct
+{
+    int header;    // block holding the label, the test and the branch
+    int latch;     // last block, ending in the jump back
+    int body;      // first instruction of the body: its label
+    int end;       // one past the last body instruction, before the jump back
+    Operand var;
+    TACOpType op;  // the loop runs while var op limit
+    int64_t limit;
+    int64_t step;
+    int test;      // the comparison in the header
+} SimpleLoop;
+
+// Per-copy renaming of the temps and labels a loop defines
+typedef struct
+{
+    uint32_t *temp;
+    int *temp_copy;
+    uint32_t *label;
+    int *label_copy;
+    int copy;
+} Renaming;
+
+static TACOpType mirror(TACOpType op)
+{
+    switch (op)
+    {
+    case TAC_LESS:
+        return TAC_GREATER;
+    case TAC_LESS_EQ:
+        return TAC_GREATER_EQ;
+    case TAC_GREATER:
+        return TAC_LESS;
+    default:
+        return TAC_LESS_EQ;
+    }
+}
+
+static bool jumps_to(const TacBuffer *tac, const TAC *jump, const BasicBlock *block)
+{
+    const TAC *label = &tac->code[block->first];
+    return label->op == TAC_LABEL && operand_equal(jump->result, label->result);
+}
+
+static bool analyze_loop(const Cfg *cfg, int l, bool *in_loop, SimpleLoop *loop)
+{
+    const TacBuffer *tac = cfg->tac;
+    const Loop *natural = &cfg->loops[l];
+    int h = natural->header;
+
+    for (int m = 0; m < cfg->loop_count; m++)
+    {
+        if (cfg->loops[m].parent == l)
+            return false;
+    }
+
+    // Header, then the exit jump outside the loop, then the body blocks in order
+    loop->header = h;
+    loop->latch = natural->blocks[natural->block_count - 1];
+    if (natural->block_count < 2 || natural->latch_count != 1 || natural->latches[0] != loop->latch ||
+        loop->latch + 1 >= cfg->block_count || loop->latch - h != natural->block_count)
+        return false;
+    for (int b = 1; b < natural->block_count; b++)
+    {
+        if (natural->blocks[b] != h + 1 + b)
+            return false;
+    }
+
+    const BasicBlock *header = &cfg->blocks[h];
+    const BasicBlock *exit_jump = &cfg->blocks[h + 1];
+    const TAC *branch = &tac->code[header->first + 2];
+    if (header->last - header->first != 3 || tac->code[header->first].op != TAC_LABEL ||
+        branch->op != TAC_IF || !jumps_to(tac, branch, &cfg->blocks[h + 2]) ||
+        exit_jump->last - exit_jump->first != 1 || tac->code[exit_jump->first].op != TAC_GOTO ||
+        !jumps_to(tac, &tac->code[exit_jump->first], &cfg->blocks[loop->latch + 1]) ||
+        tac->code[cfg->blocks[loop->latch].last - 1].op != TAC_GOTO)
+        return false;
+
+    loop->test = header->first + 1;
+    const TAC *test = &tac->code[loop->test];
+    if (!operand_equal(test->result, branch->arg1) || test->result.kind != OPERAND_TEMP)
+        return false;
+    loop->op = test->op;
+    if (test->arg1.kind == OPERAND_VAR && test->arg2.kind == OPERAND_IMM)
+    {
+        loop->var = test->arg1;
+        loop->limit = test->arg2.imm;
+    }
+    else if (test->arg2.kind == OPERAND_VAR && test->arg1.kind == OPERAND_IMM)
+    {
+        loop->var = test->arg2;
+        loop->limit = test->arg1.imm;
+        loop->op = mirror(loop->op);
+    }
+    else
+        return false;
+    if (loop->op != TAC_LESS && loop->op != TAC_LESS_EQ && loop->op != TAC_GREATER && loop->op != TAC_GREATER_EQ)
+        return false;
+
+    loop->body = cfg->blocks[h + 2].first;
+    loop->end = cfg->blocks[loop->latch].last - 1;
+
+    // The counter is stepped exactly once, in the latch, towards the limit
+    int updates = 0;
+    for (int i = loop->body; i < loop->end; i++)
+    {
+        const TAC *code = &tac->code[i];
+        if (!operand_equal(code->result, loop->var))
+            continue;
+        if (cfg->block_of[i] != loop->latch || !tac_induction_step(code, &loop->step))
+            return false;
+        updates++;
+    }
+    bool ascending = loop->op == TAC_LESS || loop->op == TAC_LESS_EQ;
+    if (updates != 1 || ascending != (loop->step > 0))
+        return false;
+
+    // Temps the loop computes must not be read after it: each copy gets its own
+    for (int b = 0; b < natural->block_count; b++)
+        in_loop[natural->blocks[b]] = true;
+    bool *defined = (bool *)region_calloc(REGION_IR, tac->temp_count + 1, sizeof(bool));
+    for (int i = header->first; i < loop->end; i++)
+    {
+        if (tac->code[i].result.kind == OPERAND_TEMP)
+            defined[tac->code[i].result.id] = true;
+    }
+    for (int i = 0; i < tac->count; i++)
+    {
+        const TAC *code = &tac->code[i];
+        if (in_loop[cfg->block_of[i]])
+            continue;
+        if ((code->arg1.kind == OPERAND_TEMP && defined[code->arg1.id]) ||
+            (code->arg2.kind == OPERAND_TEMP && defined[code->arg2.id]))
+            return false;
+    }
+
+    // Only the body is copied, so it may not read what the header computes
+    for (int i = loop->body; i < loop->end; i++)
+    {
+        const TAC *code = &tac->code[i];
+        if (operand_equal(code->arg1, test->result) || operand_equal(code->arg2, test->result))
+            return false;
+    }
+    return true;
+}
+
+// Iterations left when var starts at initial; false if the count does not fit
+// or the counter would overflow on its way out
+static bool trip_count(const SimpleLoop *loop, int64_t initial, int64_t *trips)
+{
+    bool ascending = loop->step > 0;
+    int64_t bound = loop->limit; // last value that stays in the loop
+    if (loop->op == TAC_LESS || loop->op == TAC_GREATER)
+    {
+        if (__builtin_sub_overflow(loop->limit, ascending ? 1 : -1, &bound))
+        {
+            *trips = 0;
+            return true;
+        }
+    }
+    if (ascending ? initial > bound : initial < bound)
+    {
+        *trips = 0;
+        return true;
+    }
+
+    uint64_t distance = ascending ? (uint64_t)bound - (uint64_t)initial : (uint64_t)initial - (uint64_t)bound;
+    uint64_t stride = ascending ? (uint64_t)loop->step : (uint64_t)0 - (uint64_t)loop->step;
+    uint64_t count = distance / stride + 1;
+    int64_t final;
+    if (count > INT32_MAX || __builtin_mul_overflow((int64_t)count, loop->step, &final) ||
+        __builtin_add_overflow(initial, final, &final))
+        return false;
+    *trips = (int64_t)count;
+    return true;
+}
+
+static Operand rename_operand(const Renaming *names, Operand operand)
+{
+    if (operand.kind == OPERAND_TEMP && names->temp_copy[operand.id] == names->copy)
+        return make_operand(OPERAND_TEMP, names->temp[operand.id]);
+    if (operand.kind == OPERAND_LABEL && names->label_copy[operand.id] == names->copy)
+        return make_operand(OPERAND_LABEL, names->label[operand.id]);
+    return operand;
+}
+
+// Appends one copy of code[first, last), with fresh temps and labels
+static void emit_copy(TacBuffer *tac, const TAC *code, int first, int last, Renaming *names)
+{
+    names->copy++;
+    for (int i = first; i < last; i++)
+    {
+        Operand result = code[i].result;
+        if (result.kind == OPERAND_TEMP)
+        {
+            names->temp[result.id] = generate_temp_var(tac).id;
+            names->temp_copy[result.id] = names->copy;
+        }
+        else if (code[i].op == TAC_LABEL)
+        {
+            names->label[result.id] = generate_label(tac).id;
+            names->label_copy[result.id] = names->copy;
+        }
+    }
+
+    for (int i = first; i < last; i++)
+    {
+        TAC *copy = tac_emit(tac, code[i].op, rename_operand(names, code[i].result),
+                             rename_operand(names, code[i].arg1), rename_operand(names, code[i].arg2), code[i].offset);
+        copy->type = code[i].type;
+    }
+}
+
+static void emit_code(TacBuffer *tac, const TAC *code)
+{
+    TAC *copy = tac_emit(tac, code->op, code->result, code->arg1, code->arg2, code->offset);
+    copy->type = code->type;
+}
+
+int unroll_loops(TacBuffer *tac, const OptimizerOptions *options, OptimizerStats *stats)
+{
+    if (tac->count == 0)
+        return 0;
+
+    Cfg *cfg = build_cfg(tac);
+    if (cfg->loop_count == 0)
+        return 0;
+
+    int count = tac->count;
+    SimpleLoop *loops = (SimpleLoop *)region_alloc(REGION_IR, cfg->loop_count * sizeof(SimpleLoop));
+    int *trips = (int *)region_alloc(REGION_IR, cfg->loop_count * sizeof(int)); // full copies, or -factor
+    int *plan = (int *)region_alloc(REGION_IR, (cfg->block_count + 1) * sizeof(int));
+    bool *in_loop = (bool *)region_alloc(REGION_IR, (cfg->block_count + 1) * sizeof(bool));
+    int unrolled = 0;
+
+    for (int b = 0; b < cfg->block_count; b++)
+        plan[b] = -1;
+
+    for (int l = 0; l < cfg->loop_count; l++)
+    {
+        SimpleLoop *loop = &loops[l];
+        memset(in_loop, 0, (cfg->block_count + 1) * sizeof(bool));
+        if (!analyze_loop(cfg, l, in_loop, loop))
+            continue;
+
+        int size = loop->end - loop->body;
+        int preheader = cfg_preheader(cfg, l);
+        int64_t initial, known;
+        bool counted = preheader >= 0 &&
+                       tac_constant_before(tac, cfg->blocks[preheader].first, cfg->blocks[preheader].last,
+                                           loop->var.id, &initial) &&
+                       trip_count(loop, initial, &known);
+        if (counted && known * size <= options->unroll_budget)
+        {
+            trips[l] = (int)known;
+        }
+        else
+        {
+            int factor = options->unroll_factor;
+            if (size > 0 && factor > options->unroll_budget / size)
+                factor = options->unroll_budget / size;
+
+            // The unrolled test checks that the last of the copies would still run
+            int64_t reach;
+            if (factor < 2 || (counted && known < factor) || __builtin_mul_overflow((int64_t)(factor - 1), loop->step, &reach) ||
+                __builtin_sub_overflow(loop->limit, reach, &loop->limit))
+                continue;
+            trips[l] = -factor;
+        }
+        plan[loop->header] = l;
+        unrolled++;
+    }
+
+    if (unrolled == 0)
+        return 0;
+
+    Renaming names;
+    names.temp = (uint32_t *)region_alloc(REGION_IR, (tac->temp_count + 1) * sizeof(uint32_t));
+    names.temp_copy = (int *)region_calloc(REGION_IR, tac->temp_count + 1, sizeof(int));
+    names.label = (uint32_t *)region_alloc(REGION_IR, (tac->label_count + 1) * sizeof(uint32_t));
+    names.label_copy = (int *)region_calloc(REGION_IR, tac->label_count + 1, sizeof(int));
+    names.copy = 0;
+
+    TAC *old = (TAC *)region_alloc(REGION_IR, count * sizeof(TAC));
+    memcpy(old, tac->code, count * sizeof(TAC));
+    tac->count = 0;
+
+    for (int i = 0; i < count;)
+    {
+        int l = old[i].op == TAC_LABEL ? plan[cfg->block_of[i]] : -1;
+        if (l < 0 || cfg->blocks[cfg->block_of[i]].first != i)
+        {
+            emit_code(tac, &old[i++]);
+            continue;
+        }
+
+        const SimpleLoop *loop = &loops[l];
+        const TAC *test = &old[loop->test];
+        if (trips[l] >= 0)
+        {
+            // Straight-line copies; control falls into the label after the loop
+            for (int n = 0; n < trips[l]; n++)
+                emit_copy(tac, old, loop->body, loop->end, &names);
+            i = cfg->blocks[loop->latch].last;
+            stats->unrolled++;
+            continue;
+        }
+
+        Operand start = generate_label(tac);
+        Operand body = generate_label(tac);
+        Operand condition = generate_temp_var(tac);
+        tac_emit(tac, TAC_LABEL, start, NO_OPERAND, NO_OPERAND, test->offset);
+        tac_emit(tac, loop->op, condition, loop->var, make_imm(loop->limit), test->offset);
+        tac_emit(tac, TAC_IF, body, condition, NO_OPERAND, test->offset);
+        tac_emit(tac, TAC_GOTO, old[i].result, NO_OPERAND, NO_OPERAND, test->offset);
+        tac_emit(tac, TAC_LABEL, body, NO_OPERAND, NO_OPERAND, test->offset);
+        for (int n = 0; n < -trips[l]; n++)
+            emit_copy(tac, old, loop->body, loop->end, &names);
+        tac_emit(tac, TAC_GOTO, start, NO_OPERAND, NO_OPERAND, test->offset);
+
+        // The original loop runs what is left
+        emit_code(tac, &old[i++]);
+        stats->unrolled++;
+    }
+    return unrolled;
+}
\ No newline at end of file